@@ -0,0 +1,76 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "renderer/shader/ShaderParser.h"
+
+// Measures ShaderParser on synthetic multi-section files of growing size. Every file interleaves
+// common blocks with stage sections, which is the worst case for expanding common text.
+//
+//   ParserBench [iterations]
+
+static std::string GenerateFile(std::size_t numSections, std::size_t numCommon)
+{
+  std::string body;
+  for (int line = 0; line < 40; line++)
+    body += "  value += texture(u_Texture, v_UV * " + std::to_string(line) + ".0).rgb;\n";
+
+  std::string file;
+  std::size_t commonEvery = numCommon ? numSections / numCommon : 0;
+  for (std::size_t i = 0; i < numSections; i++)
+  {
+    if (commonEvery && i % commonEvery == 0)
+      file += "#section common\nlayout(binding = 0) uniform block" + std::to_string(i) +
+              "\n{\n  mat4 u_Matrix;\n};\n\n";
+
+    const char* type = (i % 2) ? "pixel" : "vertex";
+    file += std::string("#section type(") + type + ") name(section)\n";
+    file += "#version 450 core\n\nvoid main()\n{\n  vec3 value = vec3(0.0);\n" + body + "}\n\n";
+  }
+
+  return file;
+}
+
+int main(int argc, char** argv)
+{
+  int iterations = (argc > 1) ? std::atoi(argv[1]) : 50;
+
+  struct Case
+  {
+    std::size_t Sections;
+    std::size_t Common;
+  };
+  std::vector<Case> cases = {{8, 1}, {64, 4}, {256, 16}, {1024, 64}};
+
+  std::printf("%10s %8s %12s %12s %12s\n", "sections", "common", "file (KB)", "parse (us)",
+              "MB/s");
+
+  for (const Case& test : cases)
+  {
+    std::string file = GenerateFile(test.Sections, test.Common);
+    Vision::ShaderParser parser;
+
+    // Warm up once, so allocator state doesn't skew the first sample.
+    std::size_t parsed = parser.ParseSource(file).size();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+      parsed += parser.ParseSource(file).size();
+    auto end = std::chrono::steady_clock::now();
+
+    double micros = std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+    double megabytes = file.size() / (1024.0 * 1024.0);
+    std::printf("%10zu %8zu %12.1f %12.1f %12.1f\n", test.Sections, test.Common,
+                file.size() / 1024.0, micros, megabytes / (micros / 1e6));
+
+    if (parsed != (iterations + 1) * test.Sections)
+    {
+      std::printf("unexpected section count\n");
+      return 1;
+    }
+  }
+
+  return 0;
+}
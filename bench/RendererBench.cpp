@@ -0,0 +1,402 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <glm/gtc/matrix_transform.hpp>
+#include <imgui.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "renderer/Camera.h"
+#include "renderer/RenderContext.h"
+#include "renderer/Renderer.h"
+#include "renderer/Renderer2D.h"
+#include "renderer/null/NullDevice.h"
+#include "renderer/opengl/GLDevice.h"
+#include "renderer/shader/BuiltinShaders.h"
+#include "ui/ImGuiRenderer.h"
+
+// Measures the CPU cost of a frame of Renderer2D, Renderer and ImGuiRenderer work. By default the
+// renderers draw through a NullDevice, so only the engine's own work is timed and no GPU or window
+// is needed; the device's call counters are reported too, which catches changes in how much work a
+// frame hands to the backend. On Linux, --api gl runs the same frames through a headless EGL
+// context instead (Mesa's llvmpipe works), reporting how many state changes reached the driver
+// and how many the state cache dropped. Results are written as JSON, to stdout unless -o is given.
+//
+// Heap allocations made during the timed frames are counted too. Once warmed up, a frame shouldn't
+// make any, and --fail-on-alloc turns one that does into a failure. ctest runs it that way.
+//
+//   RendererBench [-o results.json] [--frames N] [--api null|gl] [--fail-on-alloc]
+
+using Clock = std::chrono::steady_clock;
+
+// Everything allocated through new is counted, and ImGui is pointed at CountedMalloc.
+static std::atomic<std::size_t> allocations = 0;
+
+void* operator new(std::size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size ? size : 1);
+}
+
+void operator delete(void* memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+  std::free(memory);
+}
+
+static void* CountedMalloc(std::size_t size, void*)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size);
+}
+
+static void CountedFree(void* memory, void*)
+{
+  std::free(memory);
+}
+
+constexpr float benchWidth = 1280.0f, benchHeight = 720.0f;
+constexpr int warmupFrames = 3;
+
+struct ScenarioResult
+{
+  std::string Name;
+  double Milliseconds = 0.0; // per frame
+  double Allocations = 0.0;  // per frame
+  Vision::NullDevice::Counters Counters; // per frame, only with the null device
+  Vision::GLStateCache::Counters StateCalls; // per frame, only with the GL device
+};
+
+// Everything a scenario draws with. The renderers are created once, like in an App.
+struct BenchContext
+{
+  Vision::RenderDevice* Device;
+  Vision::Renderer* Renderer;
+  Vision::Renderer2D* Renderer2D;
+  Vision::ImGuiRenderer* UIRenderer;
+  Vision::OrthoCamera* Camera;
+
+  // a single quad for Renderer's draws
+  Vision::ID QuadPipeline, QuadVBO, QuadIBO;
+
+  // two opaque pipelines and four textures for draws that switch state
+  Vision::ID MixedPipelines[2];
+  Vision::ID Textures[4];
+};
+
+static void DrawQuads(BenchContext& context, std::size_t count)
+{
+  context.Renderer2D->Begin(context.Camera);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    float x = static_cast<float>(i % 200) * 0.05f - 5.0f;
+    float y = static_cast<float>(i / 200) * 0.05f - 5.0f;
+    glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f));
+    context.Renderer2D->DrawQuad(transform, glm::vec4(x, y, 1.0f, 1.0f));
+  }
+  context.Renderer2D->End();
+}
+
+static void DrawShapes(BenchContext& context, std::size_t count)
+{
+  context.Renderer2D->Begin(context.Camera);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    glm::vec2 position = {static_cast<float>(i % 100) * 0.1f - 5.0f,
+                          static_cast<float>(i / 100) * 0.1f - 5.0f};
+    context.Renderer2D->DrawPoint(position, glm::vec4(1.0f), 0.05f);
+    context.Renderer2D->DrawCircle(position, glm::vec4(1.0f), 0.05f);
+    context.Renderer2D->DrawLine(position, position + glm::vec2(0.1f), glm::vec4(1.0f), 0.01f);
+  }
+  context.Renderer2D->End();
+}
+
+static void SubmitDraws(BenchContext& context, std::size_t count)
+{
+  Vision::DrawCommand command;
+  command.Type = Vision::PrimitiveType::Triangle;
+  command.RenderPipeline = context.QuadPipeline;
+  command.VertexBuffers = {context.QuadVBO};
+  command.IndexBuffer = context.QuadIBO;
+  command.IndexType = Vision::IndexType::U32;
+  command.NumVertices = 6;
+
+  context.Renderer->Begin(context.Camera);
+  for (std::size_t i = 0; i < count; i++)
+    context.Renderer->Submit(command);
+  context.Renderer->End();
+}
+
+// Opaque draws alternating between pipelines and textures, submitted back to front. That is the
+// worst order for the state cache, which the GL device undoes by sorting unless the pass preserves
+// order, so the two passes show the state calls before and after sorting.
+static void SubmitMixedDraws(BenchContext& context, std::size_t count)
+{
+  Vision::DrawCommand command;
+  command.Type = Vision::PrimitiveType::Triangle;
+  command.VertexBuffers = {context.QuadVBO};
+  command.IndexBuffer = context.QuadIBO;
+  command.IndexType = Vision::IndexType::U32;
+  command.NumVertices = 6;
+
+  context.Renderer->Begin(context.Camera);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    command.RenderPipeline = context.MixedPipelines[i % 2];
+    command.SortDepth = static_cast<float>(count - i);
+    context.Device->BindTexture2D(context.Textures[i % 4], 1);
+    context.Renderer->Submit(command);
+  }
+  context.Renderer->End();
+}
+
+static void DrawUI(BenchContext& context, std::size_t lines)
+{
+  context.UIRenderer->Begin();
+  ImGui::Begin("RendererBench");
+  for (std::size_t i = 0; i < lines; i++)
+    ImGui::Text("line %zu of %zu", i, lines);
+  ImGui::End();
+  context.UIRenderer->End();
+}
+
+static ScenarioResult RunScenario(const std::string& name, BenchContext& context, Vision::ID pass,
+                                  int frames, const std::function<void()>& frame)
+{
+  Vision::NullDevice* nullDevice = dynamic_cast<Vision::NullDevice*>(context.Device);
+  Vision::GLDevice* glDevice = dynamic_cast<Vision::GLDevice*>(context.Device);
+  auto runFrame = [&]()
+  {
+    context.Device->BeginCommandBuffer();
+    context.Device->BeginRenderPass(pass);
+    frame();
+    context.Device->EndRenderPass();
+    context.Device->SubmitCommandBuffer();
+  };
+
+  // A few frames to warm up, since ImGui settles over more than one. The last one tells us what a
+  // single frame does.
+  for (int i = 0; i < warmupFrames - 1; i++)
+    runFrame();
+  if (nullDevice)
+    nullDevice->ResetCounters();
+  if (glDevice)
+    glDevice->ResetStateCounters();
+  runFrame();
+
+  ScenarioResult result;
+  result.Name = name;
+  if (nullDevice)
+    result.Counters = nullDevice->GetCounters();
+  if (glDevice)
+    result.StateCalls = glDevice->GetStateCache().GetCounters();
+
+  std::size_t startAllocations = allocations.load();
+  Clock::time_point start = Clock::now();
+  for (int i = 0; i < frames; i++)
+    runFrame();
+  result.Milliseconds =
+      std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+  result.Allocations = static_cast<double>(allocations.load() - startAllocations) / frames;
+
+  return result;
+}
+
+static void WriteResults(std::ostream& stream, const std::vector<ScenarioResult>& results,
+                         int frames, const char* api, bool counters)
+{
+  stream << "{\n  \"api\": \"" << api << "\",\n  \"frames\": " << frames
+         << ",\n  \"scenarios\": [\n";
+  for (std::size_t i = 0; i < results.size(); i++)
+  {
+    const ScenarioResult& result = results[i];
+    stream << "    {\"name\": \"" << result.Name << "\", \"msPerFrame\": " << result.Milliseconds
+           << ", \"allocationsPerFrame\": " << result.Allocations;
+    if (counters)
+    {
+      const Vision::NullDevice::Counters& c = result.Counters;
+      stream << ", \"draws\": " << c.Draws << ", \"vertices\": " << c.Vertices
+             << ", \"pushConstants\": " << c.PushConstants
+             << ", \"bufferUploads\": " << c.BufferUploads
+             << ", \"bufferBytes\": " << c.BufferBytes << ", \"binds\": " << c.Binds
+             << ", \"stateChanges\": " << c.StateChanges << ", \"errors\": " << c.Errors;
+    }
+    else
+    {
+      stream << ", \"stateCallsIssued\": " << result.StateCalls.Issued
+             << ", \"stateCallsSkipped\": " << result.StateCalls.Skipped;
+    }
+    stream << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  stream << "  ]\n}\n";
+}
+
+int main(int argc, char** argv)
+{
+  std::string outputPath;
+  int frames = 100;
+  Vision::RenderAPI api = Vision::RenderAPI::None;
+  bool failOnAllocation = false;
+  bool valid = true;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+      outputPath = argv[++i];
+    else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+      frames = std::max(1, std::atoi(argv[++i]));
+    else if (std::strcmp(argv[i], "--fail-on-alloc") == 0)
+      failOnAllocation = true;
+    else if (std::strcmp(argv[i], "--api") == 0 && i + 1 < argc)
+    {
+      const char* name = argv[++i];
+      if (std::strcmp(name, "gl") == 0)
+        api = Vision::RenderAPI::OpenGL;
+      else
+        valid &= (std::strcmp(name, "null") == 0);
+    }
+    else
+      valid = false;
+  }
+
+  if (!valid)
+  {
+    std::cout << "usage: RendererBench [-o results.json] [--frames N] [--api null|gl] "
+                 "[--fail-on-alloc]"
+              << std::endl;
+    return 1;
+  }
+
+  Vision::RenderContext* renderContext =
+      Vision::RenderContext::CreateHeadless(api, benchWidth, benchHeight);
+  if (!renderContext)
+    return 1;
+
+  BenchContext context;
+  context.Device = renderContext->GetRenderDevice();
+
+  // before ImGuiRenderer creates its context
+  ImGui::SetAllocatorFunctions(CountedMalloc, CountedFree);
+  context.Renderer = new Vision::Renderer(context.Device, benchWidth, benchHeight);
+  context.Renderer2D = new Vision::Renderer2D(context.Device, benchWidth, benchHeight);
+  context.UIRenderer = new Vision::ImGuiRenderer(context.Device, benchWidth, benchHeight);
+  context.Camera = new Vision::OrthoCamera(benchWidth, benchHeight, 5.0f);
+
+  // Renderer draws whatever it is given, so borrow Renderer2D's quad shader
+  Vision::RenderPipelineDesc pipelineDesc;
+  pipelineDesc.VertexShader = Vision::GetBuiltinShader("quadVertex", Vision::ShaderStage::Vertex);
+  pipelineDesc.PixelShader = Vision::GetBuiltinShader("quadPixel", Vision::ShaderStage::Pixel);
+  pipelineDesc.DeriveLayout = true;
+  pipelineDesc.Blending = false; // opaque, so the GL device can sort the draws
+  context.QuadPipeline = context.Device->CreateRenderPipeline(pipelineDesc);
+
+  context.MixedPipelines[0] = context.QuadPipeline;
+  pipelineDesc.PixelShader = Vision::GetBuiltinShader(
+      Vision::GetVariantName("quadPixel", {"TEXTURED"}), Vision::ShaderStage::Pixel);
+  context.MixedPipelines[1] = context.Device->CreateRenderPipeline(pipelineDesc);
+
+  for (std::size_t i = 0; i < 4; i++)
+  {
+    std::uint8_t pixel[] = {static_cast<std::uint8_t>(i * 64), 255, 255, 255};
+    Vision::Texture2DDesc textureDesc;
+    textureDesc.Width = 1.0f;
+    textureDesc.Height = 1.0f;
+    textureDesc.PixelType = Vision::PixelType::RGBA8;
+    textureDesc.Data = pixel;
+    context.Textures[i] = context.Device->CreateTexture2D(textureDesc);
+  }
+
+  Vision::QuadVertex vertices[4];
+  std::uint32_t indices[] = {0, 1, 2, 2, 3, 0};
+
+  Vision::BufferDesc vboDesc;
+  vboDesc.Type = Vision::BufferType::Vertex;
+  vboDesc.Usage = Vision::BufferUsage::Static;
+  vboDesc.Size = sizeof(vertices);
+  vboDesc.Data = vertices;
+  vboDesc.DebugName = "RendererBench VBO";
+  context.QuadVBO = context.Device->CreateBuffer(vboDesc);
+
+  Vision::BufferDesc iboDesc;
+  iboDesc.Type = Vision::BufferType::Index;
+  iboDesc.Usage = Vision::BufferUsage::Static;
+  iboDesc.Size = sizeof(indices);
+  iboDesc.Data = indices;
+  iboDesc.DebugName = "RendererBench IBO";
+  context.QuadIBO = context.Device->CreateBuffer(iboDesc);
+
+  Vision::RenderPassDesc passDesc;
+  passDesc.ClearColor = glm::vec4(0.0f);
+  Vision::ID pass = context.Device->CreateRenderPass(passDesc);
+  passDesc.PreserveOrder = true;
+  Vision::ID orderedPass = context.Device->CreateRenderPass(passDesc);
+
+  std::vector<ScenarioResult> results;
+  results.push_back(RunScenario("renderer2D.quads1k", context, pass, frames,
+                                [&]() { DrawQuads(context, 1000); }));
+  results.push_back(RunScenario("renderer2D.quads50k", context, pass, frames,
+                                [&]() { DrawQuads(context, 50000); }));
+  results.push_back(RunScenario("renderer2D.shapes5k", context, pass, frames,
+                                [&]() { DrawShapes(context, 5000); }));
+  results.push_back(RunScenario("renderer.draws5k", context, pass, frames,
+                                [&]() { SubmitDraws(context, 5000); }));
+  results.push_back(RunScenario("renderer.mixed2k.submissionOrder", context, orderedPass, frames,
+                                [&]() { SubmitMixedDraws(context, 2000); }));
+  results.push_back(RunScenario("renderer.mixed2k.sorted", context, pass, frames,
+                                [&]() { SubmitMixedDraws(context, 2000); }));
+  results.push_back(RunScenario("imgui.text500", context, pass, frames,
+                                [&]() { DrawUI(context, 500); }));
+
+  context.Device->DestroyRenderPass(orderedPass);
+  context.Device->DestroyRenderPass(pass);
+  for (Vision::ID texture : context.Textures)
+    context.Device->DestroyTexture2D(texture);
+  context.Device->DestroyPipeline(context.MixedPipelines[1]);
+  context.Device->DestroyBuffer(context.QuadIBO);
+  context.Device->DestroyBuffer(context.QuadVBO);
+  context.Device->DestroyPipeline(context.QuadPipeline);
+  delete context.Camera;
+  delete context.UIRenderer;
+  delete context.Renderer2D;
+  delete context.Renderer;
+
+  const char* apiName = api == Vision::RenderAPI::None ? "null" : "gl";
+  bool counters = api == Vision::RenderAPI::None;
+  bool written = true;
+  if (outputPath.empty())
+  {
+    WriteResults(std::cout, results, frames, apiName, counters);
+  }
+  else
+  {
+    std::ofstream stream(outputPath, std::ios::out | std::ios::trunc);
+    WriteResults(stream, results, frames, apiName, counters);
+    written = stream.good();
+    if (!written)
+      std::cout << "RendererBench: unable to write " << outputPath << std::endl;
+  }
+
+  // reported on stdout, so only when asked to, since the results may be going there too
+  bool allocationFree = true;
+  for (const ScenarioResult& result : results)
+  {
+    if (failOnAllocation && result.Allocations > 0.0)
+    {
+      std::cout << "RendererBench: " << result.Name << " makes " << result.Allocations
+                << " allocations per frame" << std::endl;
+      allocationFree = false;
+    }
+  }
+
+  delete renderContext;
+  return written && allocationFree ? 0 : 1;
+}
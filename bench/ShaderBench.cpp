@@ -0,0 +1,335 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "renderer/opengl/GLCompiler.h"
+#include "renderer/shader/ShaderCache.h"
+#include "renderer/shader/ShaderCompiler.h"
+#include "renderer/shader/ShaderParser.h"
+#include "renderer/shader/ShaderReflector.h"
+
+// Times every CPU stage of the shader pipeline for each file given, plus a few generated ones that
+// are much larger than anything we ship. Each stage is timed on its own and the whole pipeline end
+// to end, once cold and then warm (averaged over the iterations):
+//
+//   parse         ShaderParser::ParseFile, cold with a fresh parser, warm reusing its include cache
+//   compile       ShaderCompiler::CompileSource cold (this includes reflection), ShaderCache::Load
+//                 of the same section warm
+//   reflect       ShaderReflector parsing the SPIRV cold, deserializing the stored reflection warm
+//   crossCompile  GLCompiler's spirv-cross step, cold with a fresh compiler, warm from its cache
+//
+// The GLSL is never handed to a driver, so this runs without a GPU or a window. Results are written
+// as JSON, to stdout unless -o is given. Compile errors are printed to stdout too.
+//
+//   ShaderBench [-o results.json] [--iterations N] [--no-synthetic] resources/*.glsl
+
+using Clock = std::chrono::steady_clock;
+
+static double MillisecondsSince(Clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct Timing
+{
+  double Cold = 0.0;
+  double Warm = 0.0;
+};
+
+struct ShaderResult
+{
+  std::string Name;
+  Vision::ShaderStage Stage;
+  std::size_t SPIRVBytes = 0;
+  Timing Compile, Reflect, CrossCompile;
+};
+
+struct FileResult
+{
+  std::string File;
+  std::size_t Bytes = 0;
+  bool Synthetic = false;
+  Timing Parse, EndToEnd;
+  std::vector<ShaderResult> Shaders;
+};
+
+// A vertex and pixel section per pair, each doing `lines` statements of arithmetic. Unlike
+// ParserBench's files these have to compile, so they stay valid GLSL.
+static std::string GenerateFile(std::size_t pairs, std::size_t lines)
+{
+  std::string body;
+  for (std::size_t line = 0; line < lines; line++)
+  {
+    std::string scale = std::to_string(1.0 + line * 0.001);
+    body += "  value = value * " + scale + " + vec3(sin(value.y), cos(value.z), " + scale + ");\n";
+  }
+
+  std::string file;
+  for (std::size_t i = 0; i < pairs; i++)
+  {
+    std::string index = std::to_string(i);
+    file += "#section type(vertex) name(syntheticVertex" + index + ")\n#version 450 core\n\n";
+    file += "layout(location = 0) in vec3 a_Position;\nlayout(location = 0) out vec3 v_Value;\n\n";
+    file += "void main()\n{\n  vec3 value = a_Position;\n" + body;
+    file += "  v_Value = value;\n  gl_Position = vec4(value, 1.0);\n}\n\n";
+
+    file += "#section type(pixel) name(syntheticPixel" + index + ")\n#version 450 core\n\n";
+    file += "layout(location = 0) in vec3 v_Value;\nlayout(location = 0) out vec4 f_Color;\n\n";
+    file += "void main()\n{\n  vec3 value = v_Value;\n" + body;
+    file += "  f_Color = vec4(value, 1.0);\n}\n\n";
+  }
+
+  return file;
+}
+
+// Parse, then compile or load every section, reflect and cross-compile it.
+static void RunPipeline(const std::string& filePath, Vision::ShaderParser& parser,
+                        Vision::ShaderCompiler& compiler, const Vision::ShaderCache& cache,
+                        Vision::GLCompiler& glCompiler)
+{
+  for (const Vision::ShaderSource& source : parser.ParseFile(filePath))
+  {
+    std::uint64_t key = Vision::ShaderCache::ComputeKey(source, compiler.GetOptions());
+
+    Vision::ShaderSPIRV shader;
+    if (!cache.Load(key, shader))
+    {
+      shader = compiler.CompileSource(source);
+      if (shader.GetCode().empty())
+        continue;
+      cache.Store(key, shader);
+    }
+    shader.Stage = source.Stage;
+    shader.Name = source.Name;
+
+    Vision::ShaderReflector::GetReflection(shader);
+    glCompiler.Decompile(shader, 450);
+  }
+}
+
+static FileResult BenchmarkFile(const std::string& filePath, int iterations,
+                                const std::string& cacheDirectory)
+{
+  FileResult result;
+  result.File = filePath;
+  result.Bytes = std::filesystem::file_size(filePath);
+
+  // parse
+  Vision::ShaderParser parser;
+  Clock::time_point start = Clock::now();
+  std::vector<Vision::ShaderSource> sources = parser.ParseFile(filePath);
+  result.Parse.Cold = MillisecondsSince(start);
+
+  start = Clock::now();
+  for (int i = 0; i < iterations; i++)
+    parser.ParseFile(filePath);
+  result.Parse.Warm = MillisecondsSince(start) / iterations;
+
+  // each stage of each section on its own
+  Vision::ShaderCompiler compiler;
+  Vision::ShaderCache cache(cacheDirectory);
+  for (const Vision::ShaderSource& source : sources)
+  {
+    ShaderResult shaderResult;
+    shaderResult.Name = source.Name;
+    shaderResult.Stage = source.Stage;
+
+    start = Clock::now();
+    Vision::ShaderSPIRV shader = compiler.CompileSource(source);
+    shaderResult.Compile.Cold = MillisecondsSince(start);
+    if (shader.GetCode().empty())
+      continue;
+    shaderResult.SPIRVBytes = shader.GetCode().size_bytes();
+
+    std::uint64_t key = Vision::ShaderCache::ComputeKey(source, compiler.GetOptions());
+    cache.Store(key, shader);
+    start = Clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+      Vision::ShaderSPIRV loaded;
+      cache.Load(key, loaded);
+    }
+    shaderResult.Compile.Warm = MillisecondsSince(start) / iterations;
+
+    start = Clock::now();
+    Vision::ShaderReflection reflection = Vision::ShaderReflector(shader).Reflect();
+    shaderResult.Reflect.Cold = MillisecondsSince(start);
+
+    std::vector<std::uint8_t> stored = reflection.Serialize();
+    start = Clock::now();
+    for (int i = 0; i < iterations; i++)
+      reflection.Deserialize(stored.data(), stored.size());
+    shaderResult.Reflect.Warm = MillisecondsSince(start) / iterations;
+
+    Vision::GLCompiler glCompiler;
+    start = Clock::now();
+    glCompiler.Decompile(shader, 450);
+    shaderResult.CrossCompile.Cold = MillisecondsSince(start);
+
+    start = Clock::now();
+    for (int i = 0; i < iterations; i++)
+      glCompiler.Decompile(shader, 450);
+    shaderResult.CrossCompile.Warm = MillisecondsSince(start) / iterations;
+
+    result.Shaders.push_back(shaderResult);
+  }
+
+  // end to end, cold with nothing cached anywhere, then warm with every cache populated
+  std::filesystem::remove_all(cacheDirectory);
+  Vision::ShaderCache pipelineCache(cacheDirectory);
+  Vision::ShaderParser pipelineParser;
+  Vision::GLCompiler glCompiler;
+
+  start = Clock::now();
+  RunPipeline(filePath, pipelineParser, compiler, pipelineCache, glCompiler);
+  result.EndToEnd.Cold = MillisecondsSince(start);
+
+  start = Clock::now();
+  for (int i = 0; i < iterations; i++)
+    RunPipeline(filePath, pipelineParser, compiler, pipelineCache, glCompiler);
+  result.EndToEnd.Warm = MillisecondsSince(start) / iterations;
+
+  return result;
+}
+
+static const char* StageToString(Vision::ShaderStage stage)
+{
+  switch (stage)
+  {
+    case Vision::ShaderStage::Vertex: return "vertex";
+    case Vision::ShaderStage::Pixel: return "pixel";
+    case Vision::ShaderStage::Compute: return "compute";
+    case Vision::ShaderStage::Domain: return "domain";
+    case Vision::ShaderStage::Hull: return "hull";
+    case Vision::ShaderStage::Geometry: return "geometry";
+    default: return "invalid";
+  }
+}
+
+static void WriteTiming(std::ostream& stream, const char* name, const Timing& timing)
+{
+  stream << "\"" << name << "\": {\"cold\": " << timing.Cold << ", \"warm\": " << timing.Warm
+         << "}";
+}
+
+static void WriteResults(std::ostream& stream, const std::vector<FileResult>& results,
+                         int iterations)
+{
+  stream << "{\n  \"iterations\": " << iterations << ",\n  \"files\": [\n";
+  for (std::size_t i = 0; i < results.size(); i++)
+  {
+    const FileResult& file = results[i];
+    stream << "    {\n";
+    stream << "      \"file\": \"" << file.File << "\",\n";
+    stream << "      \"bytes\": " << file.Bytes << ",\n";
+    stream << "      \"synthetic\": " << (file.Synthetic ? "true" : "false") << ",\n      ";
+    WriteTiming(stream, "parse", file.Parse);
+    stream << ",\n      ";
+    WriteTiming(stream, "endToEnd", file.EndToEnd);
+    stream << ",\n      \"shaders\": [\n";
+
+    for (std::size_t j = 0; j < file.Shaders.size(); j++)
+    {
+      const ShaderResult& shader = file.Shaders[j];
+      stream << "        {\"name\": \"" << shader.Name << "\", \"stage\": \""
+             << StageToString(shader.Stage) << "\", \"spirvBytes\": " << shader.SPIRVBytes << ", ";
+      WriteTiming(stream, "compile", shader.Compile);
+      stream << ", ";
+      WriteTiming(stream, "reflect", shader.Reflect);
+      stream << ", ";
+      WriteTiming(stream, "crossCompile", shader.CrossCompile);
+      stream << "}" << (j + 1 < file.Shaders.size() ? "," : "") << "\n";
+    }
+
+    stream << "      ]\n    }" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  stream << "  ]\n}\n";
+}
+
+int main(int argc, char** argv)
+{
+  std::string outputPath;
+  std::vector<std::string> inputs;
+  int iterations = 10;
+  bool synthetic = true;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+      outputPath = argv[++i];
+    else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+      iterations = std::max(1, std::atoi(argv[++i]));
+    else if (std::strcmp(argv[i], "--no-synthetic") == 0)
+      synthetic = false;
+    else
+      inputs.push_back(argv[i]);
+  }
+
+  // Everything the benchmark writes lives here, so it never touches a real cache.
+  std::filesystem::path scratch = std::filesystem::temp_directory_path() / "vision-shaderbench";
+  std::filesystem::remove_all(scratch);
+  std::filesystem::create_directories(scratch);
+
+  std::vector<std::pair<std::string, bool>> files;
+  for (const std::string& input : inputs)
+    files.push_back({input, false});
+
+  if (synthetic)
+  {
+    struct Size
+    {
+      std::size_t Pairs;
+      std::size_t Lines;
+    };
+    for (Size size : {Size{4, 100}, Size{16, 500}, Size{32, 2000}})
+    {
+      std::string name = "synthetic" + std::to_string(size.Pairs) + "x" +
+                         std::to_string(size.Lines) + ".glsl";
+      std::string path = (scratch / name).string();
+      std::ofstream(path, std::ios::out | std::ios::trunc) << GenerateFile(size.Pairs, size.Lines);
+      files.push_back({path, true});
+    }
+  }
+
+  if (files.empty())
+  {
+    std::cout << "usage: ShaderBench [-o results.json] [--iterations N] [--no-synthetic] "
+                 "<shader files...>"
+              << std::endl;
+    return 1;
+  }
+
+  std::vector<FileResult> results;
+  for (const auto& [file, isSynthetic] : files)
+  {
+    std::cerr << "ShaderBench: " << file << std::endl;
+    results.push_back(BenchmarkFile(file, iterations, (scratch / "spirv").string()));
+    results.back().Synthetic = isSynthetic;
+  }
+
+  if (outputPath.empty())
+  {
+    WriteResults(std::cout, results, iterations);
+  }
+  else
+  {
+    std::ofstream stream(outputPath, std::ios::out | std::ios::trunc);
+    WriteResults(stream, results, iterations);
+    if (!stream.good())
+    {
+      std::cout << "ShaderBench: unable to write " << outputPath << std::endl;
+      return 1;
+    }
+  }
+
+  std::filesystem::remove_all(scratch);
+  return 0;
+}
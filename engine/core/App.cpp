@@ -42,6 +42,12 @@ void App::Run()
     Input::Update();
     ProcessEvents();
 
+    // Edited shaders have already been recompiled by the watcher, the device swaps them in at the
+    // start of the next frame.
+    if (shaderWatcher->HasReloads())
+      for (const ShaderReload& reload : shaderWatcher->TakeReloads())
+        renderDevice->ReplaceShader(reload.OldCodeHash, reload.NewCodeHash, reload.Shader);
+
     // Update App
     OnUpdate(timestep);
   }
@@ -66,13 +72,16 @@ void App::Init()
 
   // Initialize Rendering Objects
   renderDevice = renderContext->GetRenderDevice();
-  renderer = new Renderer(displayWidth, displayHeight, displayScale);
+  renderer = new Renderer(renderDevice, displayWidth, displayHeight, displayScale);
   renderer2D = new Renderer2D(renderDevice, displayWidth, displayHeight, displayScale);
   uiRenderer = new ImGuiRenderer(renderDevice, displayWidth, displayHeight, displayScale);
+
+  shaderWatcher = new ShaderWatcher();
 }
 
 void App::Shutdown()
 {
+  delete shaderWatcher;
   delete renderer2D;
   delete uiRenderer;
   delete renderer;
@@ -12,6 +12,8 @@
 #include "renderer/Renderer.h"
 #include "renderer/Renderer2D.h"
 
+#include "renderer/shader/ShaderWatcher.h"
+
 namespace Vision
 {
 
@@ -28,6 +30,9 @@ public:
   static RenderDevice* GetDevice() { return appInstance->renderDevice; }
   static PixelType GetPixelFormat() { return appInstance->renderContext->GetPixelType(); }
 
+  // Attach to a ShaderCompiler to hot reload the files it compiles.
+  static ShaderWatcher* GetShaderWatcher() { return appInstance->shaderWatcher; }
+
 protected:
   virtual void OnUpdate(float timestep) = 0;
   virtual void OnResize(float width, float height) {} // Not mandatory to implement
@@ -56,6 +61,8 @@ private:
   float displayScale; // Used for retina rendering
   bool displayOccluded = false;
 
+  ShaderWatcher* shaderWatcher;
+
 protected:
   RenderDevice* renderDevice;
   RenderContext* renderContext;
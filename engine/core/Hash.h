@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace Vision
+{
+
+// Stable 64-bit FNV-1a hash. Unlike std::hash, the result is identical across runs, compilers and
+// platforms, so it is safe to use for anything that is written to disk.
+constexpr std::uint64_t HashSeed = 0xcbf29ce484222325ull;
+
+inline std::uint64_t Hash64(const void* data, std::size_t size, std::uint64_t seed = HashSeed)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  std::uint64_t hash = seed;
+  for (std::size_t i = 0; i < size; i++)
+  {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+inline std::uint64_t Hash64(std::string_view string, std::uint64_t seed = HashSeed)
+{
+  return Hash64(string.data(), string.size(), seed);
+}
+
+// Folds a plain value into a running hash.
+template <typename T>
+inline std::uint64_t Hash64Value(const T& value, std::uint64_t seed)
+{
+  return Hash64(&value, sizeof(T), seed);
+}
+
+} // namespace Vision
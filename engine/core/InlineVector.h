@@ -0,0 +1,71 @@
+#pragma once
+
+#include <SDL.h>
+#include <cstddef>
+#include <initializer_list>
+#include <span>
+
+namespace Vision
+{
+
+// A vector with a fixed capacity that lives inside the object, so filling one never allocates.
+// Meant for small, trivially copyable things, such as the buffer IDs of a draw.
+template <typename T, std::size_t Capacity> class InlineVector
+{
+public:
+  InlineVector() = default;
+  InlineVector(std::initializer_list<T> list) { *this = list; }
+
+  InlineVector& operator=(std::initializer_list<T> list)
+  {
+    SDL_assert(list.size() <= Capacity);
+    count = 0;
+    for (const T& item : list)
+      items[count++] = item;
+    return *this;
+  }
+
+  void push_back(const T& item)
+  {
+    SDL_assert(count < Capacity);
+    items[count++] = item;
+  }
+
+  void resize(std::size_t size, const T& value = T())
+  {
+    SDL_assert(size <= Capacity);
+    for (std::size_t i = count; i < size; i++)
+      items[i] = value;
+    count = size;
+  }
+
+  void clear() { count = 0; }
+
+  std::size_t size() const { return count; }
+  static constexpr std::size_t capacity() { return Capacity; }
+  bool empty() const { return count == 0; }
+
+  T& operator[](std::size_t index) { return items[index]; }
+  const T& operator[](std::size_t index) const { return items[index]; }
+  const T& at(std::size_t index) const
+  {
+    SDL_assert(index < count);
+    return items[index];
+  }
+
+  T* data() { return items; }
+  const T* data() const { return items; }
+
+  T* begin() { return items; }
+  T* end() { return items + count; }
+  const T* begin() const { return items; }
+  const T* end() const { return items + count; }
+
+  operator std::span<const T>() const { return {items, count}; }
+
+private:
+  T items[Capacity] = {};
+  std::size_t count = 0;
+};
+
+} // namespace Vision
@@ -13,3 +13,7 @@
 #if defined(_WIN32)
 #define VISION_WINDOWS
 #endif // _WIN32
+
+#if defined(__linux__)
+#define VISION_LINUX
+#endif // __linux__
@@ -0,0 +1,103 @@
+#include "MappedFile.h"
+
+#include "Macros.h"
+
+#include <iostream>
+
+#ifdef VISION_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Vision
+{
+
+#ifdef VISION_WINDOWS
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+  HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    std::cout << "Failed to open file for mapping: " << filePath << std::endl;
+    return;
+  }
+
+  LARGE_INTEGER fileSize;
+  GetFileSizeEx(file, &fileSize);
+  if (fileSize.QuadPart == 0)
+  {
+    CloseHandle(file);
+    return;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping)
+  {
+    std::cout << "Failed to map file: " << filePath << std::endl;
+    CloseHandle(file);
+    return;
+  }
+
+  fileHandle = file;
+  mappingHandle = mapping;
+  data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  size = static_cast<std::size_t>(fileSize.QuadPart);
+}
+
+MappedFile::~MappedFile()
+{
+  if (data)
+    UnmapViewOfFile(data);
+  if (mappingHandle)
+    CloseHandle(mappingHandle);
+  if (fileHandle)
+    CloseHandle(fileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+  int file = open(filePath.c_str(), O_RDONLY);
+  if (file < 0)
+  {
+    std::cout << "Failed to open file for mapping: " << filePath << std::endl;
+    return;
+  }
+
+  struct stat info;
+  if (fstat(file, &info) != 0 || info.st_size == 0)
+  {
+    close(file);
+    return;
+  }
+
+  void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file); // the mapping holds its own reference to the file
+
+  if (mapping == MAP_FAILED)
+  {
+    std::cout << "Failed to map file: " << filePath << std::endl;
+    return;
+  }
+
+  data = mapping;
+  size = static_cast<std::size_t>(info.st_size);
+}
+
+MappedFile::~MappedFile()
+{
+  if (data)
+    munmap(const_cast<void*>(data), size);
+}
+
+#endif
+
+} // namespace Vision
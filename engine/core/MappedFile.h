@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "Macros.h"
+
+namespace Vision
+{
+
+// Read-only memory mapping of an entire file. The contents stay valid until the object is
+// destroyed, so anything handing out pointers into the mapping must keep it alive.
+class MappedFile
+{
+public:
+  MappedFile(const std::string& filePath);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool IsValid() const { return data != nullptr; }
+  const void* GetData() const { return data; }
+  std::size_t GetSize() const { return size; }
+
+private:
+  const void* data = nullptr;
+  std::size_t size = 0;
+
+#ifdef VISION_WINDOWS
+  void* fileHandle = nullptr;
+  void* mappingHandle = nullptr;
+#endif
+};
+
+} // namespace Vision
@@ -0,0 +1,116 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace Vision
+{
+
+ThreadPool::ThreadPool(std::size_t numThreads)
+{
+  if (numThreads == 0)
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+  workers.reserve(numThreads);
+  for (std::size_t i = 0; i < numThreads; i++)
+    workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  jobAvailable.notify_all();
+
+  for (std::thread& worker : workers)
+    worker.join();
+}
+
+std::future<void> ThreadPool::Submit(std::function<void()> job)
+{
+  std::packaged_task<void()> task(std::move(job));
+  std::future<void> future = task.get_future();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back(std::move(task));
+  }
+  jobAvailable.notify_one();
+
+  return future;
+}
+
+void ThreadPool::Wait()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  jobsFinished.wait(lock, [this]() { return jobs.empty() && activeJobs == 0; });
+}
+
+void ThreadPool::Wait(std::vector<std::future<void>>& futures)
+{
+  for (std::future<void>& future : futures)
+  {
+    while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+      if (!RunQueuedJob())
+        future.wait(); // it is already running on a worker
+    }
+  }
+}
+
+bool ThreadPool::RunQueuedJob()
+{
+  std::packaged_task<void()> task;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (jobs.empty())
+      return false;
+
+    task = std::move(jobs.front());
+    jobs.pop_front();
+    activeJobs++;
+  }
+
+  task();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    activeJobs--;
+    if (jobs.empty() && activeJobs == 0)
+      jobsFinished.notify_all();
+  }
+  return true;
+}
+
+void ThreadPool::WorkerLoop()
+{
+  while (true)
+  {
+    std::packaged_task<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+
+      // We only exit once the queue is drained so no submitted future is left hanging.
+      if (jobs.empty())
+        return;
+
+      task = std::move(jobs.front());
+      jobs.pop_front();
+      activeJobs++;
+    }
+
+    task();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      activeJobs--;
+      if (jobs.empty() && activeJobs == 0)
+        jobsFinished.notify_all();
+    }
+  }
+}
+
+} // namespace Vision
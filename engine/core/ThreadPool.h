@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Vision
+{
+
+// Small fixed-size worker pool. Jobs are executed in submission order by whichever worker is free,
+// so callers that need a deterministic result order should write into preallocated slots rather
+// than relying on completion order.
+class ThreadPool
+{
+public:
+  ThreadPool(std::size_t numThreads = 0); // zero picks one worker per hardware thread
+  ~ThreadPool();
+
+  std::future<void> Submit(std::function<void()> job);
+
+  // Blocks until every job submitted so far has finished running.
+  void Wait();
+
+  // Blocks until the given jobs have finished. Queued jobs are run on the calling thread meanwhile,
+  // so waiting from inside a job can't starve the pool.
+  void Wait(std::vector<std::future<void>>& futures);
+
+  std::size_t GetNumThreads() const { return workers.size(); }
+
+private:
+  void WorkerLoop();
+  bool RunQueuedJob(); // runs the next job on this thread, if there is one
+
+private:
+  std::vector<std::thread> workers;
+  std::deque<std::packaged_task<void()>> jobs;
+
+  std::mutex mutex;
+  std::condition_variable jobAvailable;
+  std::condition_variable jobsFinished;
+  std::size_t activeJobs = 0;
+  bool stopping = false;
+};
+
+} // namespace Vision
@@ -2,6 +2,8 @@
 
 #include <glm/glm.hpp>
 
+#include "core/InlineVector.h"
+
 #include "primitive/Buffer.h"
 #include "primitive/Pipeline.h"
 #include "primitive/Texture.h"
@@ -27,19 +29,29 @@ enum class PrimitiveType
 
 using ID = std::size_t;
 
+// Everything is stored inline, so building and submitting draws never allocates.
 struct DrawCommand
 {
+  static constexpr std::size_t MaxVertexBuffers = 8;
+
   PrimitiveType Type;
 
   ID RenderPipeline;
 
-  std::vector<ID> VertexBuffers;
+  InlineVector<ID, MaxVertexBuffers> VertexBuffers;
   ID IndexBuffer = 0;
   IndexType IndexType = IndexType::U32;
 
   std::size_t NumVertices = 0;
-  std::vector<std::size_t> VertexOffsets;
+  InlineVector<std::size_t, MaxVertexBuffers> VertexOffsets;
   std::size_t IndexOffset = 0;
+
+  // View depth of the draw. Devices that sort draws put opaque ones front to back with it.
+  float SortDepth = 0.0f;
+
+  // Pipelines created asynchronously may not be ready yet. By default the draw is dropped until
+  // they are; setting this makes the device finish building the pipeline first instead.
+  bool WaitForPipeline = false;
 };
 
 } // namespace Vision
\ No newline at end of file
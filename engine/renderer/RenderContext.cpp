@@ -6,17 +6,30 @@
 
 #include "renderer/RenderAPI.h"
 
+#include "renderer/null/NullContext.h"
 #include "renderer/opengl/GLContext.h"
 
 #ifdef VISION_MACOS
 #include "renderer/metal/MetalContext.h"
 #endif
 
+#ifdef VISION_LINUX
+#include "renderer/opengl/GLHeadlessContext.h"
+#endif
+
 namespace Vision
 {
 
 RenderContext* RenderContext::Create(RenderAPI api, SDL_Window* window)
 {
+  // The null device is the same everywhere, it just takes the window's size
+  if (api == RenderAPI::None)
+  {
+    int width, height;
+    SDL_GetWindowSizeInPixels(window, &width, &height);
+    return new NullContext(static_cast<float>(width), static_cast<float>(height));
+  }
+
 #ifdef VISION_MACOS
   switch (api)
   {
@@ -43,6 +56,40 @@ RenderContext* RenderContext::Create(RenderAPI api, SDL_Window* window)
   SDL_assert(false);
   return nullptr;
 #endif
+
+#ifdef VISION_LINUX
+  switch (api)
+  {
+    case RenderAPI::OpenGL: return new GLContext(window);
+    default:
+      break;
+  }
+
+  std::cout << "Unsupported RenderAPI on Linux!" << std::endl;
+  SDL_assert(false);
+  return nullptr;
+#endif
+}
+
+RenderContext* RenderContext::CreateHeadless(RenderAPI api, float width, float height)
+{
+  if (api == RenderAPI::None)
+    return new NullContext(width, height);
+
+#ifdef VISION_LINUX
+  if (api == RenderAPI::OpenGL)
+  {
+    GLHeadlessContext* context = new GLHeadlessContext(width, height);
+    if (context->IsValid())
+      return context;
+
+    delete context;
+    return nullptr;
+  }
+#endif
+
+  std::cout << "Unsupported headless RenderAPI on this platform!" << std::endl;
+  return nullptr;
 }
 
 }
\ No newline at end of file
@@ -12,6 +12,11 @@ class RenderContext
 {
 public:
   static RenderContext* Create(RenderAPI api, SDL_Window* window);
+
+  // A context without a window, for tools and benchmarks. RenderAPI::None creates a NullContext on
+  // any platform, and RenderAPI::OpenGL an offscreen EGL context on Linux. Returns null if the API
+  // isn't available headless.
+  static RenderContext* CreateHeadless(RenderAPI api, float width, float height);
   virtual ~RenderContext() = default;
 
   virtual void Resize(float width, float height) = 0;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <span>
+
 #include "renderer/primitive/Buffer.h"
 #include "renderer/primitive/Pipeline.h"
 #include "renderer/primitive/RenderPass.h"
@@ -21,10 +23,34 @@ public:
   static RenderDevice* Create(RenderAPI API);
   virtual ~RenderDevice() {}
 
-  // render pipeline
+  // render pipeline. Backends may hand out the same ID for identical descriptions, so every Create
+  // must be paired with its own Destroy.
   virtual ID CreateRenderPipeline(const RenderPipelineDesc& desc) = 0;
   virtual void DestroyPipeline(ID id) = 0;
 
+  // Non-blocking pipeline creation. The ID can be used immediately, but the heavy lifting happens
+  // off the calling thread, and the pipeline is only picked up at the start of a later command
+  // buffer. Until then, draws against it follow DrawCommand::WaitForPipeline, while compute
+  // dispatches always wait. Backends without background builds simply build it here.
+  virtual ID CreateRenderPipelineAsync(const RenderPipelineDesc& desc)
+  {
+    return CreateRenderPipeline(desc);
+  }
+  virtual ID CreateComputePipelineAsync(const ComputePipelineDesc& desc)
+  {
+    return CreateComputePipeline(desc);
+  }
+  virtual bool IsPipelineReady(ID id) { return true; }
+
+  // Rebuilds every pipeline that uses the shader identified by oldCodeHash (see
+  // ShaderSPIRV::GetCodeHash) with the new code, whose hash is newCodeHash. The swap happens at the
+  // start of the next command buffer, so it never lands in the middle of a frame. Used for hot
+  // reloading.
+  virtual void ReplaceShader(std::uint64_t oldCodeHash, std::uint64_t newCodeHash,
+                             const ShaderSPIRV& shader)
+  {
+  }
+
   virtual ID CreateBuffer(const BufferDesc& desc) = 0;
   virtual void SetBufferData(ID buffer, void* data, std::size_t size, std::size_t offset = 0) = 0;
   virtual void MapBufferData(ID buffer, void** data, std::size_t size) = 0;
@@ -74,6 +100,19 @@ public:
   virtual void SetScissorRect(float x, float y, float width, float height) = 0;
   virtual void Submit(const DrawCommand& command) = 0;
 
+  // Submits the draws in order, as if each was passed to Submit.
+  virtual void Submit(std::span<const DrawCommand> commands)
+  {
+    for (const DrawCommand& command : commands)
+      Submit(command);
+  }
+
+  // Sets the contents of the shaders' push constant block (see PushConstantBinding) for the draws
+  // or dispatches that follow in the current pass. This is for small data that changes every draw,
+  // so no buffer has to be created or uploaded. The size should cover the whole block.
+  static constexpr std::size_t MaxPushConstantSize = 4096;
+  virtual void PushConstants(const void* data, std::size_t size) = 0;
+
   // compute pipeline
   virtual ID CreateComputePipeline(const ComputePipelineDesc& desc) = 0;
   virtual void DestroyComputePipeline(ID id) = 0;
@@ -3,12 +3,12 @@
 #include <SDL.h>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "core/App.h"
 #include "core/Input.h"
 
 namespace Vision
 {
 
+// Shaders see this through resources/include/pushConstants.glsl, keep the two in sync.
 struct PushConstant
 {
   glm::mat4 view;
@@ -20,25 +20,13 @@ struct PushConstant
   float dummy = 0.0f; // metal requires 16 byte alignment
 };
 
-Renderer::Renderer(float width, float height, float displayScale)
-    : m_Width(width), m_Height(height), m_PixelDensity(displayScale)
+Renderer::Renderer(RenderDevice* device, float width, float height, float displayScale)
+    : m_Device(device), m_Width(width), m_Height(height), m_PixelDensity(displayScale)
 {
-  // TODO: Push constants will probably be parts of pipeline states.
-  {
-    BufferDesc desc;
-    desc.Type = BufferType::Uniform;
-    desc.Usage = BufferUsage::Dynamic;
-    desc.Size = sizeof(PushConstant);
-    desc.Data = nullptr;
-    desc.DebugName = "Renderer Data";
-
-    pushConstants = App::GetDevice()->CreateBuffer(desc);
-  }
 }
 
 Renderer::~Renderer()
 {
-  App::GetDevice()->DestroyBuffer(pushConstants);
 }
 
 void Renderer::Resize(float width, float height)
@@ -75,6 +63,10 @@ void Renderer::DrawMesh(Mesh* mesh, ID pipeline, const glm::mat4& transform)
   command.IndexType = IndexType::U32;
   command.Type = PrimitiveType::Triangle;
 
+  // distance in front of the camera, so devices that sort can draw opaque meshes front to back
+  if (m_Camera)
+    command.SortDepth = -(m_Camera->GetViewMatrix() * transform[3]).z;
+
   Renderer::Submit(command);
 }
 
@@ -99,12 +91,11 @@ void Renderer::Submit(const DrawCommand& command)
     data.viewInverse = glm::inverse(data.view);
     data.viewSize = {m_Width, m_Height};
     data.time = time;
-    App::GetDevice()->SetBufferData(pushConstants, &data, sizeof(PushConstant));
-    App::GetDevice()->BindBuffer(pushConstants, 0);
+    m_Device->PushConstants(&data, sizeof(PushConstant));
   }
 
   // device submit
-  App::GetDevice()->Submit(command);
+  m_Device->Submit(command);
 }
 
 } // namespace Vision
@@ -14,7 +14,7 @@ namespace Vision
 class Renderer
 {
 public:
-  Renderer(float width, float height, float displayScale = 1.0f);
+  Renderer(RenderDevice* device, float width, float height, float displayScale = 1.0f);
   ~Renderer();
   
   void Resize(float width, float height);
@@ -22,18 +22,18 @@ public:
   void Begin(Camera* camera);
   void End();
 
+  // Opaque meshes should use pipelines created with Blending = false. Devices that sort draws keep
+  // blended ones in submission order.
   void DrawMesh(Mesh* mesh, ID pipeline, const glm::mat4& transform = glm::mat4(1.0f));
 
   void Submit(const DrawCommand& command);
 
 private:  
+  RenderDevice* m_Device = nullptr;
   bool m_InFrame = false;
   Camera* m_Camera = nullptr;
   float m_PixelDensity = 1.0f;
   float m_Width, m_Height;
-
-  // Eventually, these will be baked into pipeline states, but for now we'll use a uniform buffer
-  ID pushConstants;
 };
 
 }
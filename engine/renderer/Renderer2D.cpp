@@ -4,7 +4,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "renderer/shader/ShaderCompiler.h"
+#include "renderer/shader/BuiltinShaders.h"
 
 namespace Vision
 {
@@ -215,32 +215,40 @@ void Renderer2D::Flush()
   device->SetBufferData(matrixUBO, &mvp[0][0], sizeof(glm::mat4));
   device->BindBuffer(matrixUBO);
 
+  // Everything is uploaded before the draws are submitted together, since devices that record
+  // draws have to flush them before an upload.
+  DrawCommand commands[2];
+  std::size_t numCommands = 0;
+
   // Quads
   if (numQuads != 0)
   {
     // copy the quad buffer into the vbo
     device->SetBufferData(quadVBO, quadBuffer, sizeof(QuadVertex) * 4 * numQuads);
 
-    // Bind Textures
-    device->BindTexture2D(whiteTexture);
-    for (std::size_t i = 0; i < maxTextures; ++i)
+    // Batches of plain colored quads use the variant that doesn't sample at all.
+    bool textured = numUserTextures != 0;
+    if (textured)
     {
-      // HACK: macOS prefers we bind a texture, even if not used.
-      ID texture = textures[i] ? textures[i] : whiteTexture;
-      device->BindTexture2D(texture, i + 1); // bind to slots 1-15
+      device->BindTexture2D(whiteTexture);
+      for (std::size_t i = 0; i < maxTextures; ++i)
+      {
+        // HACK: macOS prefers we bind a texture, even if not used.
+        ID texture = textures[i] ? textures[i] : whiteTexture;
+        device->BindTexture2D(texture, i + 1); // bind to slots 1-15
 
-      // Reset the texture once we're done with it
-      textures[i] = 0;
+        // Reset the texture once we're done with it
+        textures[i] = 0;
+      }
     }
 
-    DrawCommand cmd;
+    DrawCommand& cmd = commands[numCommands++];
     cmd.Type = PrimitiveType::Triangle;
     cmd.VertexBuffers = {quadVBO};
     cmd.NumVertices = numQuads * 6;
     cmd.IndexType = IndexType::U32;
     cmd.IndexBuffer = quadIBO;
-    cmd.RenderPipeline = quadPipeline;
-    device->Submit(cmd);
+    cmd.RenderPipeline = textured ? texturedQuadPipeline : quadPipeline;
   }
 
   quadBufferHead = quadBuffer;
@@ -252,18 +260,19 @@ void Renderer2D::Flush()
   {
     device->SetBufferData(pointVBO, pointBuffer, sizeof(PointVertex) * 4 * numPoints);
 
-    DrawCommand cmd;
+    DrawCommand& cmd = commands[numCommands++];
     cmd.Type = PrimitiveType::Triangle;
     cmd.VertexBuffers = {pointVBO};
     cmd.NumVertices = numPoints * 6;
     cmd.IndexType = IndexType::U32;
     cmd.IndexBuffer = quadIBO;
     cmd.RenderPipeline = pointPipeline;
-    device->Submit(cmd);
   }
 
   pointBufferHead = pointBuffer;
   numPoints = 0;
+
+  device->Submit(std::span<const DrawCommand>(commands, numCommands));
 }
 
 void Renderer2D::GenerateBuffers()
@@ -329,159 +338,28 @@ void Renderer2D::GenerateBuffers()
   }
 }
 
-const char* quadVertex = R"(
-#version 450 core
-
-layout (location = 0) in vec2 a_Position;
-layout (location = 1) in vec4 a_Color;
-layout (location = 2) in vec2 a_UV;
-layout (location = 3) in int a_TextureID;
-layout (location = 4) in float a_TilingFactor;
-
-out vec2 v_UV;
-out vec4 v_Color;
-flat out int v_TextureID;
-
-layout (binding = 0) uniform matrices 
-{
-  mat4 mvp;
-};
-
-void main()
-{  
-  gl_Position = mvp * vec4(a_Position, 0.0, 1.0);
-  
-  v_UV = a_UV * a_TilingFactor;
-  v_Color = a_Color;
-  v_TextureID = a_TextureID;
-})";
-
-const char* quadPixel = R"(
-#version 450 core
-
-in vec2 v_UV;
-in vec4 v_Color;
-flat in int v_TextureID;
-
-out vec4 FragColor;
-
-layout (binding = 0) uniform sampler2D u_Textures[16];
-
-void main()
-{
-  vec4 texColor = v_Color;
-
-  switch(int(v_TextureID))
-	{
-		case  0: texColor *= texture(u_Textures[ 0], v_UV.st); break;
-		case  1: texColor *= texture(u_Textures[ 1], v_UV.st); break;
-		case  2: texColor *= texture(u_Textures[ 2], v_UV.st); break;
-		case  3: texColor *= texture(u_Textures[ 3], v_UV.st); break;
-		case  4: texColor *= texture(u_Textures[ 4], v_UV.st); break;
-		case  5: texColor *= texture(u_Textures[ 5], v_UV.st); break;
-		case  6: texColor *= texture(u_Textures[ 6], v_UV.st); break;
-		case  7: texColor *= texture(u_Textures[ 7], v_UV.st); break;
-		case  8: texColor *= texture(u_Textures[ 8], v_UV.st); break;
-		case  9: texColor *= texture(u_Textures[ 9], v_UV.st); break;
-		case 10: texColor *= texture(u_Textures[10], v_UV.st); break;
-		case 11: texColor *= texture(u_Textures[11], v_UV.st); break;
-		case 12: texColor *= texture(u_Textures[12], v_UV.st); break;
-		case 13: texColor *= texture(u_Textures[13], v_UV.st); break;
-		case 14: texColor *= texture(u_Textures[14], v_UV.st); break;
-		case 15: texColor *= texture(u_Textures[15], v_UV.st); break;
-	}
-
-  FragColor = texColor;
-})";
-
-const char* pointVertex = R"(
-#version 450 core
-
-layout (location = 0) in vec2 a_Position;
-layout (location = 1) in vec4 a_Color;
-layout (location = 2) in vec2 a_UV;
-layout (location = 3) in float a_Border;
-
-out vec2 v_UVNorm;
-out vec4 v_Color;
-out float v_Border;
-
-layout (binding = 0) uniform matrices 
-{
-  mat4 mvp;
-};
-
-void main()
-{  
-  gl_Position = mvp * vec4(a_Position, 0.0, 1.0);
-
-  v_Color = a_Color;
-  v_UVNorm = a_UV * 2.0 - 1.0; // normalize from -1 to 1
-  v_Border = a_Border;
-})";
-
-const char* pointPixel = R"(
-#version 450 core
-
-in vec2 v_UVNorm;
-in vec4 v_Color;
-in float v_Border;
-
-out vec4 FragColor;
-
-void main()
-{
-  float dist = length(v_UVNorm);
-  float radius = 1.0;
-
-	float delta = fwidth(dist);
-	float outerFade = smoothstep(radius + delta, radius - delta, dist);
-  float innerFade = 1.0 - float(v_Border > 0) * smoothstep(radius - v_Border + delta, radius - v_Border - delta, dist);
-  float alpha = min(outerFade, innerFade);
-
-	FragColor = vec4(v_Color.xyz, v_Color.w * alpha);
-})";
-
 void Renderer2D::GeneratePipelines()
 {
   // Quads
-  ShaderCompiler compiler;
-  ShaderSource quadVS = {ShaderStage::Vertex, "quadVertex", quadVertex};
-  ShaderSource quadFS = {ShaderStage::Pixel, "quadPixel", quadPixel};
-
   RenderPipelineDesc quadDesc;
-  quadDesc.VertexShader = compiler.CompileSource(quadVS);
-  quadDesc.PixelShader = compiler.CompileSource(quadFS);
-  quadDesc.Layouts = {
-      BufferLayout({{ShaderDataType::Float2, "a_Position"},
-                    {ShaderDataType::Float4, "a_Color"},
-                    {ShaderDataType::Float2, "a_UV"},
-                    {ShaderDataType::Int, "a_TextureID"},
-                    {ShaderDataType::Float, "a_TilingFactor"}}
-      )
-  };
+  quadDesc.VertexShader = GetBuiltinShader("quadVertex", ShaderStage::Vertex);
+  quadDesc.PixelShader = GetBuiltinShader("quadPixel", ShaderStage::Pixel);
+  quadDesc.DeriveLayout = true; // QuadVertex declares the shader inputs in order
   quadDesc.DepthTest = false;
   quadDesc.DepthWrite = false;
   quadDesc.FillMode = GeometryFillMode::Line;
   quadDesc.Blending = true;
   quadPipeline = device->CreateRenderPipeline(quadDesc);
 
-  // Point
-  ShaderSource pointVS = {ShaderStage::Vertex, "pointVertex", pointVertex};
-  ShaderSource pointFS = {ShaderStage::Pixel, "pointPixel", pointPixel};
+  quadDesc.PixelShader =
+      GetBuiltinShader(GetVariantName("quadPixel", {"TEXTURED"}), ShaderStage::Pixel);
+  texturedQuadPipeline = device->CreateRenderPipeline(quadDesc);
 
+  // Point
   RenderPipelineDesc pointDesc;
-  pointDesc.VertexShader = compiler.CompileSource(pointVS);
-  pointDesc.PixelShader = compiler.CompileSource(pointFS);
-  pointDesc.Layouts = {
-      BufferLayout({
-                    {ShaderDataType::Float2, "a_Position"},
-                    {ShaderDataType::Float4, "a_Color"},
-                    {ShaderDataType::Float2, "a_UV"},
-                    {ShaderDataType::Float, "a_Border"},
-                    }
-      )
-  };
+  pointDesc.VertexShader = GetBuiltinShader("pointVertex", ShaderStage::Vertex);
+  pointDesc.PixelShader = GetBuiltinShader("pointPixel", ShaderStage::Pixel);
+  pointDesc.DeriveLayout = true; // as does PointVertex
   pointDesc.DepthTest = false;
   pointDesc.DepthWrite = false;
   pointDesc.Blending = true;
@@ -516,6 +394,7 @@ void Renderer2D::DestroyBuffers()
 void Renderer2D::DestroyPipelines()
 {
   device->DestroyPipeline(quadPipeline);
+  device->DestroyPipeline(texturedQuadPipeline);
   device->DestroyPipeline(pointPipeline);
 }
 
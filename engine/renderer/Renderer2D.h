@@ -10,6 +10,7 @@
 namespace Vision
 {
 
+// Both vertex types mirror their shader's inputs, the pipelines derive their layouts from them.
 struct QuadVertex
 {
   glm::vec2 Position;
@@ -83,6 +84,7 @@ private:
   QuadVertex *quadBuffer, *quadBufferHead;
   ID quadVBO, quadIBO;
   ID quadPipeline, quadShader;
+  ID texturedQuadPipeline; // only used for batches that sample a user texture
   
   // Texture Info
   const std::size_t maxTextures = 15;
@@ -3,18 +3,30 @@
 #include <iostream>
 #include <spirv_msl.hpp>
 
+#include "renderer/shader/ShaderReflector.h"
+
 namespace Vision
 {
   
-MTL::Function* MetalCompiler::Compile(MTL::Device* device, const ShaderSPIRV& shader)
+MTL::Function* MetalCompiler::Compile(MTL::Device* device, const ShaderSPIRV& shader,
+                                      const std::vector<SpecializationConstant>& constants)
 {
   // First perform the decompilation on the SPIRV
-  spirv_cross::CompilerMSL decompiler(shader.SPIRV);
+  spirv_cross::CompilerMSL decompiler(shader.GetCode().data(), shader.GetCode().size());
 
   spirv_cross::CompilerMSL::Options options;
   options.enable_decoration_binding = true;
   options.set_msl_version(3, 0);
   decompiler.set_msl_options(options);
+  ApplySpecializationConstants(decompiler, constants);
+
+  // Buffer indices follow bindings, so push_constant blocks join the block at PushConstantBinding
+  spirv_cross::MSLResourceBinding pushConstants;
+  pushConstants.stage = decompiler.get_execution_model();
+  pushConstants.desc_set = spirv_cross::kPushConstDescSet;
+  pushConstants.binding = spirv_cross::kPushConstBinding;
+  pushConstants.msl_buffer = PushConstantBinding;
+  decompiler.add_msl_resource_binding(pushConstants);
 
   std::string msl = decompiler.compile();
 
@@ -10,7 +10,8 @@ namespace Vision
 class MetalCompiler
 {
 public:
-  MTL::Function* Compile(MTL::Device* device, const ShaderSPIRV& spirv);
+  MTL::Function* Compile(MTL::Device* device, const ShaderSPIRV& spirv,
+                         const std::vector<SpecializationConstant>& constants = {});
 };
 
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "MetalDevice.h"
 
 #include <SDL.h>
+#include <chrono>
 #include <dispatch/dispatch.h>
 #include <iostream>
 #include <spirv_msl.hpp>
@@ -43,6 +44,13 @@ MetalDevice::MetalDevice(MTL::Device* device, CA::MetalLayer* l, float w, float
 
 MetalDevice::~MetalDevice()
 {
+  // finish any builds in flight so they don't outlive the device
+  for (auto& pair : pendingPipelines)
+  {
+    ResolvePendingPipeline(pair.first, pair.second);
+  }
+  pendingPipelines.clear();
+
   delete depthTexture;
 
   // These are all retain so they don't get delete before this class.
@@ -59,6 +67,45 @@ ID MetalDevice::CreateRenderPipeline(const RenderPipelineDesc& desc)
   return id;
 }
 
+ID MetalDevice::CreateRenderPipelineAsync(const RenderPipelineDesc& desc)
+{
+  ID id = currentID++;
+
+  // map nodes never move, so the job can write straight into its entry
+  PendingPipeline& pending = pendingPipelines[id];
+  pending.Work = pipelineWorkers.Submit(
+      [this, desc, result = &pending.Render]()
+      {
+        NS::AutoreleasePool* pool = NS::AutoreleasePool::alloc()->init();
+        *result = new MetalPipeline(gpuDevice, desc);
+        pool->release();
+      });
+
+  return id;
+}
+
+void MetalDevice::DestroyPipeline(ID id)
+{
+  auto pending = pendingPipelines.find(id);
+  if (pending != pendingPipelines.end())
+  {
+    ResolvePendingPipeline(pending->first, pending->second);
+    pendingPipelines.erase(pending);
+  }
+
+  pipelines.Destroy(id);
+}
+
+void MetalDevice::ResolvePendingPipeline(ID id, PendingPipeline& pending)
+{
+  pending.Work.wait();
+
+  if (pending.Render)
+    pipelines.Add(id, pending.Render);
+  if (pending.Compute)
+    computePipelines.Add(id, pending.Compute);
+}
+
 ID MetalDevice::CreateBuffer(const BufferDesc& desc)
 {
   ID id = currentID++;
@@ -265,6 +312,19 @@ void MetalDevice::BeginCommandBuffer()
 {
   SDL_assert(!cmdBuffer);
 
+  // pick up any async pipelines that finished building since last frame
+  for (auto it = pendingPipelines.begin(); it != pendingPipelines.end();)
+  {
+    if (it->second.Work.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+      it++;
+      continue;
+    }
+
+    ResolvePendingPipeline(it->first, it->second);
+    it = pendingPipelines.erase(it);
+  }
+
   cmdBuffer = queue->commandBuffer();
 }
 
@@ -324,10 +384,40 @@ void MetalDevice::SetScissorRect(float x, float y, float width, float height)
   encoder->setScissorRect(rect);
 }
 
+void MetalDevice::PushConstants(const void* data, std::size_t size)
+{
+  SDL_assert(size <= MaxPushConstantSize);
+
+  // Metal copies the bytes into the command buffer itself, no buffer of ours is involved.
+  if (encoder)
+  {
+    encoder->setVertexBytes(data, size, PushConstantBinding);
+    encoder->setFragmentBytes(data, size, PushConstantBinding);
+  }
+  else if (computeEncoder)
+  {
+    computeEncoder->setBytes(data, size, PushConstantBinding);
+  }
+}
+
 void MetalDevice::Submit(const DrawCommand& command)
 {
   SDL_assert(encoder);
 
+  // pipelines that are still building are skipped unless the command asks us to wait
+  if (!pendingPipelines.empty())
+  {
+    auto pending = pendingPipelines.find(command.RenderPipeline);
+    if (pending != pendingPipelines.end())
+    {
+      if (!command.WaitForPipeline)
+        return;
+
+      ResolvePendingPipeline(pending->first, pending->second);
+      pendingPipelines.erase(pending);
+    }
+  }
+
   // fetch the pipeline state
   MetalPipeline* ps = pipelines.Get(command.RenderPipeline);
   encoder->setRenderPipelineState(ps->GetPipeline());
@@ -378,6 +468,34 @@ ID MetalDevice::CreateComputePipeline(const ComputePipelineDesc& desc)
   return id;
 }
 
+ID MetalDevice::CreateComputePipelineAsync(const ComputePipelineDesc& desc)
+{
+  ID id = currentID++;
+
+  PendingPipeline& pending = pendingPipelines[id];
+  pending.Work = pipelineWorkers.Submit(
+      [this, desc, result = &pending.Compute]()
+      {
+        NS::AutoreleasePool* pool = NS::AutoreleasePool::alloc()->init();
+        *result = new MetalComputePipeline(gpuDevice, desc);
+        pool->release();
+      });
+
+  return id;
+}
+
+void MetalDevice::DestroyComputePipeline(ID id)
+{
+  auto pending = pendingPipelines.find(id);
+  if (pending != pendingPipelines.end())
+  {
+    ResolvePendingPipeline(pending->first, pending->second);
+    pendingPipelines.erase(pending);
+  }
+
+  computePipelines.Destroy(id);
+}
+
 void MetalDevice::BeginComputePass()
 {
   SDL_assert(cmdBuffer);
@@ -417,6 +535,14 @@ void MetalDevice::DispatchCompute(ID pipeline, const std::string& name, const gl
 {
   SDL_assert(computeEncoder);
 
+  // dispatches usually produce data something else depends on, so they always wait
+  auto pending = pendingPipelines.find(pipeline);
+  if (pending != pendingPipelines.end())
+  {
+    ResolvePendingPipeline(pending->first, pending->second);
+    pendingPipelines.erase(pending);
+  }
+
   MetalComputePipeline* ps = computePipelines.Get(pipeline);
   MetalComputePipeline::Kernel kernel = ps->GetKernel(name);
 
@@ -1,11 +1,15 @@
 #pragma once
 
 #include <Metal/Metal.hpp>
+#include <future>
+#include <unordered_map>
 #include <QuartzCore/CAMetalLayer.hpp>
 
 #include "renderer/RenderDevice.h"
 #include "renderer/primitive/ObjectCache.h"
 
+#include "core/ThreadPool.h"
+
 #include "MetalBuffer.h"
 #include "MetalFramebuffer.h"
 #include "MetalPipeline.h"
@@ -25,7 +29,9 @@ public:
   ~MetalDevice();
 
   ID CreateRenderPipeline(const RenderPipelineDesc& desc);
-  void DestroyPipeline(ID id) { pipelines.Destroy(id); }
+  ID CreateRenderPipelineAsync(const RenderPipelineDesc& desc);
+  bool IsPipelineReady(ID id) { return !pendingPipelines.contains(id); }
+  void DestroyPipeline(ID id);
 
   ID CreateBuffer(const BufferDesc& desc);
   void SetBufferData(ID buffer, void* data, std::size_t size, std::size_t offset);
@@ -67,7 +73,9 @@ public:
 
   void SetViewport(float x, float y, float width, float height);
   void SetScissorRect(float x, float y, float width, float height);
+  void PushConstants(const void* data, std::size_t size);
   void Submit(const DrawCommand& command);
+  using RenderDevice::Submit;
 
   // GPU-GPU memory sync in Metal is extremely easy, since the driver
   // will manage all memory created from a device unless explicitly disabled.
@@ -80,7 +88,8 @@ public:
 
   // compute pipeline
   ID CreateComputePipeline(const ComputePipelineDesc& desc);
-  void DestroyComputePipeline(ID id) { computePipelines.Destroy(id); }
+  ID CreateComputePipelineAsync(const ComputePipelineDesc& desc);
+  void DestroyComputePipeline(ID id);
 
   void BeginComputePass();
   void EndComputePass();
@@ -106,6 +115,16 @@ private:
   void UpdateSize(float w, float h);
   float width, height;
 
+  // Metal objects may be created from any thread, so async pipelines are built entirely on the
+  // workers. The result is moved into the regular caches once the render thread picks it up.
+  struct PendingPipeline
+  {
+    std::future<void> Work;
+    MetalPipeline* Render = nullptr;
+    MetalComputePipeline* Compute = nullptr;
+  };
+  void ResolvePendingPipeline(ID id, PendingPipeline& pending);
+
 private:
   // gpu device
   MTL::Device* gpuDevice;
@@ -139,6 +158,10 @@ private:
   std::size_t maxFramesInFlight = 3, inFlightFrame = 0;
   bool inFlight = false;
   std::shared_ptr<DispatchSemaphore> dispatchSemaphore;
+
+  // async pipeline builds. the pool is declared last so it's torn down first.
+  std::unordered_map<ID, PendingPipeline> pendingPipelines;
+  ThreadPool pipelineWorkers;
 };
 
 } // namespace Vision
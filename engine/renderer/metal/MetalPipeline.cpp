@@ -34,11 +34,11 @@ MetalPipeline::MetalPipeline(MTL::Device* device, const RenderPipelineDesc& desc
   // compile and attach our shader functions
   MetalCompiler shaderCompiler;
 
-  MTL::Function* vertexFunc = shaderCompiler.Compile(device, desc.VertexShader);
+  MTL::Function* vertexFunc = shaderCompiler.Compile(device, desc.VertexShader, desc.Constants);
   attribs->setVertexFunction(vertexFunc);
   vertexFunc->release();
 
-  MTL::Function* fragmentFunc = shaderCompiler.Compile(device, desc.PixelShader);
+  MTL::Function* fragmentFunc = shaderCompiler.Compile(device, desc.PixelShader, desc.Constants);
   attribs->setFragmentFunction(fragmentFunc);
   fragmentFunc->release();
 
@@ -46,15 +46,25 @@ MetalPipeline::MetalPipeline(MTL::Device* device, const RenderPipelineDesc& desc
   MTL::VertexDescriptor* vtxDesc = MTL::VertexDescriptor::alloc()->init();
 
   // build the free buffer bindings
-  ShaderReflector vtxReflector(desc.VertexShader);
-  std::vector<ShaderReflector::UniformBuffer> ubos = vtxReflector.GetUniformBuffers();
+  std::shared_ptr<const ShaderReflection> vtxReflection =
+      ShaderReflector::GetReflection(desc.VertexShader);
+  const std::vector<ShaderReflection::Resource>& ubos = vtxReflection->UniformBuffers;
+
+  std::vector<BufferLayout> layouts = desc.Layouts;
+  if (desc.DeriveLayout)
+    layouts = {BufferLayout::FromReflection(*vtxReflection)};
+
+#ifndef NDEBUG
+  ValidateBufferLayouts(layouts, *vtxReflection, desc.VertexShader.Name);
+#endif
+
   constexpr std::size_t maxSlot = 30; // this is the last slot in the table
   stageBufferBindings.clear();
 
   for (std::size_t i = 0; i <= maxSlot; i++)
   {
-    bool found = false;
-    for (auto ubo : ubos) // nested loop isn't great
+    bool found = (i == PushConstantBinding); // reserved even if this shader doesn't use it
+    for (const auto& ubo : ubos) // nested loop isn't great
       found |= (ubo.Binding == i);
 
     if (found)
@@ -62,13 +72,13 @@ MetalPipeline::MetalPipeline(MTL::Device* device, const RenderPipelineDesc& desc
 
     stageBufferBindings.push_back(i);
 
-    if (stageBufferBindings.size() == desc.Layouts.size()) // we have enough slots.
+    if (stageBufferBindings.size() == layouts.size()) // we have enough slots.
       break;
   }
 
   int stageBuffer = 0;
   int attrib = 0;
-  for (auto layout : desc.Layouts)
+  for (auto layout : layouts)
   {
     SDL_assert(stageBuffer <
                stageBufferBindings.size()); // We can't have more stage slots than free slots
@@ -82,6 +92,9 @@ MetalPipeline::MetalPipeline(MTL::Device* device, const RenderPipelineDesc& desc
 
     for (auto elem : layout.Elements)
     {
+      if (elem.Location != BufferElement::NextLocation)
+        attrib = elem.Location;
+
       vtxDesc->attributes()->object(attrib)->setBufferIndex(layoutIndex);
       vtxDesc->attributes()->object(attrib)->setFormat(
           ShaderDataTypeToMTLVertexFormat(elem.Type, elem.Normalized));
@@ -137,8 +150,7 @@ MetalComputePipeline::MetalComputePipeline(MTL::Device* device, const ComputePip
 
   for (auto& computeKernel : desc.ComputeKernels)
   {
-    MTL::Function* kernelFunc = compiler.Compile(device, computeKernel);
-    ShaderReflector reflector(computeKernel);
+    MTL::Function* kernelFunc = compiler.Compile(device, computeKernel, desc.Constants);
 
     Kernel kernel;
     kernel.Pipeline = device->newComputePipelineState(kernelFunc, &error);
@@ -149,7 +161,8 @@ MetalComputePipeline::MetalComputePipeline(MTL::Device* device, const ComputePip
       std::cout << error->description()->cString(NS::UTF8StringEncoding) << std::endl;
     }
 
-    glm::ivec3 size = reflector.GetThreadgroupSize();
+    glm::ivec3 size = ShaderReflector::GetThreadgroupSize(
+        *ShaderReflector::GetReflection(computeKernel), desc.Constants);
     kernel.WorkgroupSize = {NS::UInteger(size.x), NS::UInteger(size.y), NS::UInteger(size.z)};
 
     kernels[computeKernel.Name] = kernel;
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "renderer/RenderContext.h"
+#include "renderer/null/NullDevice.h"
+
+namespace Vision
+{
+
+// Context for the NullDevice. It needs no window, so it exists on every platform.
+class NullContext : public RenderContext
+{
+public:
+  NullContext(float w, float h)
+      : device(w, h)
+  {
+  }
+
+  void Resize(float width, float height) { device.Resize(width, height); }
+
+  RenderDevice* GetRenderDevice() { return &device; }
+  float GetDisplayScale() const { return 1.0f; }
+  PixelType GetPixelType() const { return PixelType::RGBA8; }
+
+private:
+  NullDevice device;
+};
+
+} // namespace Vision
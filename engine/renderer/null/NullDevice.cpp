@@ -0,0 +1,405 @@
+#include "NullDevice.h"
+
+#include <iostream>
+
+namespace Vision
+{
+
+const char* NullDevice::ObjectTypeToString(ObjectType type)
+{
+  switch (type)
+  {
+    case ObjectType::RenderPipeline: return "render pipeline";
+    case ObjectType::ComputePipeline: return "compute pipeline";
+    case ObjectType::Buffer: return "buffer";
+    case ObjectType::Texture2D: return "texture";
+    case ObjectType::Cubemap: return "cubemap";
+    case ObjectType::Framebuffer: return "framebuffer";
+    case ObjectType::RenderPass: return "render pass";
+    default: return "object";
+  }
+}
+
+NullDevice::NullDevice(float w, float h)
+    : width(w), height(h)
+{
+}
+
+NullDevice::~NullDevice()
+{
+  // Anything still alive here was leaked by whoever created it
+  if (!objects.empty())
+    std::cout << "NullDevice: " << objects.size() << " objects were never destroyed" << std::endl;
+}
+
+bool NullDevice::Check(bool condition, const char* call, const char* message)
+{
+  if (!condition)
+    Report(call, message);
+  return condition;
+}
+
+void NullDevice::Report(const char* call, const std::string& message)
+{
+  counters.Errors++;
+  std::cout << "NullDevice: " << call << ": " << message << std::endl;
+}
+
+ID NullDevice::AddObject(const Object& object)
+{
+  ID id = currentID++;
+  objects.emplace(id, object);
+  counters.ObjectsCreated++;
+  return id;
+}
+
+NullDevice::Object* NullDevice::GetObject(ID id, ObjectType type, const char* call)
+{
+  auto object = objects.find(id);
+  if (object == objects.end())
+  {
+    Report(call, std::string("no ") + ObjectTypeToString(type) + " with ID " + std::to_string(id));
+    return nullptr;
+  }
+
+  if (object->second.Type != type)
+  {
+    Report(call, "ID " + std::to_string(id) + " is a " + ObjectTypeToString(object->second.Type) +
+                     ", not a " + ObjectTypeToString(type));
+    return nullptr;
+  }
+
+  return &object->second;
+}
+
+void NullDevice::DestroyObject(ID id, ObjectType type, const char* call)
+{
+  if (!GetObject(id, type, call))
+    return;
+
+  objects.erase(id);
+  counters.ObjectsDestroyed++;
+}
+
+ID NullDevice::CreateRenderPipeline(const RenderPipelineDesc& desc)
+{
+  Check(!desc.VertexShader.GetCode().empty() && !desc.PixelShader.GetCode().empty(),
+        "CreateRenderPipeline", "missing vertex or pixel shader");
+
+  Object pipeline = {ObjectType::RenderPipeline};
+  pipeline.NumLayouts = desc.DeriveLayout ? 0 : desc.Layouts.size();
+  return AddObject(pipeline);
+}
+
+void NullDevice::DestroyPipeline(ID id)
+{
+  DestroyObject(id, ObjectType::RenderPipeline, "DestroyPipeline");
+}
+
+ID NullDevice::CreateBuffer(const BufferDesc& desc)
+{
+  if (desc.Size == 0)
+    Report("CreateBuffer", desc.DebugName + " has no size");
+
+  Object buffer = {ObjectType::Buffer};
+  buffer.Size = desc.Size;
+  buffer.Buffer = desc.Type;
+  return AddObject(buffer);
+}
+
+void NullDevice::SetBufferData(ID id, void* data, std::size_t size, std::size_t offset)
+{
+  counters.BufferUploads++;
+  counters.BufferBytes += size;
+
+  Object* buffer = GetObject(id, ObjectType::Buffer, "SetBufferData");
+  if (buffer && offset + size > buffer->Size)
+    Report("SetBufferData", "writing " + std::to_string(size) + " bytes at " +
+                                std::to_string(offset) + " overflows a buffer of " +
+                                std::to_string(buffer->Size));
+}
+
+void NullDevice::MapBufferData(ID id, void** data, std::size_t size)
+{
+  Object* buffer = GetObject(id, ObjectType::Buffer, "MapBufferData");
+  if (buffer)
+    Check(size <= buffer->Size, "MapBufferData", "mapping more than the buffer holds");
+
+  mapping.assign(size, 0);
+  *data = mapping.data();
+}
+
+void NullDevice::FreeBufferData(ID id, void** data)
+{
+  GetObject(id, ObjectType::Buffer, "FreeBufferData");
+  Check(*data == mapping.data(), "FreeBufferData", "the buffer isn't mapped");
+  *data = nullptr;
+}
+
+void NullDevice::ResizeBuffer(ID id, std::size_t size)
+{
+  if (Object* buffer = GetObject(id, ObjectType::Buffer, "ResizeBuffer"))
+    buffer->Size = size;
+}
+
+void NullDevice::BindBuffer(ID id, std::size_t binding, std::size_t offset, std::size_t range)
+{
+  counters.Binds++;
+
+  Object* buffer = GetObject(id, ObjectType::Buffer, "BindBuffer");
+  if (buffer)
+    Check(offset + range <= buffer->Size, "BindBuffer", "range exceeds the buffer");
+}
+
+void NullDevice::DestroyBuffer(ID id)
+{
+  DestroyObject(id, ObjectType::Buffer, "DestroyBuffer");
+}
+
+ID NullDevice::CreateTexture2D(const Texture2DDesc& desc)
+{
+  Check(desc.LoadFromFile || (desc.Width > 0 && desc.Height > 0), "CreateTexture2D",
+        "texture has no size");
+
+  if (desc.Data)
+    counters.TextureUploads++;
+  return AddObject({ObjectType::Texture2D});
+}
+
+void NullDevice::ResizeTexture2D(ID id, float w, float h)
+{
+  GetObject(id, ObjectType::Texture2D, "ResizeTexture2D");
+  Check(w > 0 && h > 0, "ResizeTexture2D", "texture has no size");
+}
+
+void NullDevice::SetTexture2DData(ID id, uint8_t* data)
+{
+  counters.TextureUploads++;
+  GetObject(id, ObjectType::Texture2D, "SetTexture2DData");
+}
+
+void NullDevice::SetTexture2DDataRaw(ID id, void* data)
+{
+  counters.TextureUploads++;
+  GetObject(id, ObjectType::Texture2D, "SetTexture2DDataRaw");
+}
+
+void NullDevice::BindTexture2D(ID id, std::size_t binding)
+{
+  counters.Binds++;
+  GetObject(id, ObjectType::Texture2D, "BindTexture2D");
+}
+
+void NullDevice::DestroyTexture2D(ID id)
+{
+  DestroyObject(id, ObjectType::Texture2D, "DestroyTexture2D");
+}
+
+ID NullDevice::CreateCubemap(const CubemapDesc& desc)
+{
+  Check(desc.Textures.size() == 6, "CreateCubemap", "cubemaps need six faces");
+  return AddObject({ObjectType::Cubemap});
+}
+
+void NullDevice::BindCubemap(ID id, std::size_t binding)
+{
+  counters.Binds++;
+  GetObject(id, ObjectType::Cubemap, "BindCubemap");
+}
+
+void NullDevice::DestroyCubemap(ID id)
+{
+  DestroyObject(id, ObjectType::Cubemap, "DestroyCubemap");
+}
+
+ID NullDevice::CreateFramebuffer(const FramebufferDesc& desc)
+{
+  Check(desc.Width > 0 && desc.Height > 0, "CreateFramebuffer", "framebuffer has no size");
+
+  // Like GLDevice, the attachments are textures of their own
+  Object framebuffer = {ObjectType::Framebuffer};
+  framebuffer.ColorTexture = AddObject({ObjectType::Texture2D});
+  framebuffer.DepthTexture = AddObject({ObjectType::Texture2D});
+  return AddObject(framebuffer);
+}
+
+ID NullDevice::GetFramebufferColorTex(ID id)
+{
+  Object* framebuffer = GetObject(id, ObjectType::Framebuffer, "GetFramebufferColorTex");
+  return framebuffer ? framebuffer->ColorTexture : 0;
+}
+
+ID NullDevice::GetFramebufferDepthTex(ID id)
+{
+  Object* framebuffer = GetObject(id, ObjectType::Framebuffer, "GetFramebufferDepthTex");
+  return framebuffer ? framebuffer->DepthTexture : 0;
+}
+
+void NullDevice::ResizeFramebuffer(ID id, float w, float h)
+{
+  GetObject(id, ObjectType::Framebuffer, "ResizeFramebuffer");
+  Check(w > 0 && h > 0, "ResizeFramebuffer", "framebuffer has no size");
+}
+
+void NullDevice::DestroyFramebuffer(ID id)
+{
+  Object* framebuffer = GetObject(id, ObjectType::Framebuffer, "DestroyFramebuffer");
+  if (!framebuffer)
+    return;
+
+  DestroyObject(framebuffer->ColorTexture, ObjectType::Texture2D, "DestroyFramebuffer");
+  DestroyObject(framebuffer->DepthTexture, ObjectType::Texture2D, "DestroyFramebuffer");
+  DestroyObject(id, ObjectType::Framebuffer, "DestroyFramebuffer");
+}
+
+ID NullDevice::CreateRenderPass(const RenderPassDesc& desc)
+{
+  if (desc.Framebuffer)
+    GetObject(desc.Framebuffer, ObjectType::Framebuffer, "CreateRenderPass");
+
+  return AddObject({ObjectType::RenderPass});
+}
+
+void NullDevice::BeginRenderPass(ID pass)
+{
+  counters.RenderPasses++;
+  Check(commandBufferActive, "BeginRenderPass", "no command buffer is active");
+  Check(!activePass && !computePass, "BeginRenderPass", "another pass is active");
+
+  GetObject(pass, ObjectType::RenderPass, "BeginRenderPass");
+  activePass = pass;
+}
+
+void NullDevice::EndRenderPass()
+{
+  Check(activePass, "EndRenderPass", "no render pass is active");
+  activePass = 0;
+}
+
+void NullDevice::DestroyRenderPass(ID pass)
+{
+  Check(pass != activePass, "DestroyRenderPass", "the pass is still active");
+  DestroyObject(pass, ObjectType::RenderPass, "DestroyRenderPass");
+}
+
+void NullDevice::BeginCommandBuffer()
+{
+  counters.CommandBuffers++;
+  Check(!commandBufferActive, "BeginCommandBuffer", "a command buffer is already active");
+  commandBufferActive = true;
+}
+
+void NullDevice::SubmitCommandBuffer(bool await)
+{
+  Check(commandBufferActive, "SubmitCommandBuffer", "no command buffer is active");
+  Check(!activePass && !computePass, "SubmitCommandBuffer", "a pass is still active");
+  commandBufferActive = false;
+}
+
+void NullDevice::SchedulePresentation()
+{
+  Check(commandBufferActive && !activePass, "SchedulePresentation",
+        "must be called in a command buffer, outside of any pass");
+}
+
+void NullDevice::SetViewport(float x, float y, float w, float h)
+{
+  counters.StateChanges++;
+}
+
+void NullDevice::SetScissorRect(float x, float y, float w, float h)
+{
+  counters.StateChanges++;
+  Check(activePass, "SetScissorRect", "no render pass is active");
+}
+
+void NullDevice::Submit(const DrawCommand& command)
+{
+  counters.Draws++;
+  counters.Vertices += command.NumVertices;
+  Check(activePass, "Submit", "no render pass is active");
+
+  Object* pipeline = GetObject(command.RenderPipeline, ObjectType::RenderPipeline, "Submit");
+  if (pipeline && pipeline->NumLayouts && command.VertexBuffers.size() != pipeline->NumLayouts)
+    Report("Submit", "the pipeline takes " + std::to_string(pipeline->NumLayouts) +
+                         " vertex buffers, " + std::to_string(command.VertexBuffers.size()) +
+                         " were given");
+
+  for (ID id : command.VertexBuffers)
+  {
+    Object* buffer = GetObject(id, ObjectType::Buffer, "Submit");
+    if (buffer)
+      Check(buffer->Buffer == BufferType::Vertex, "Submit", "vertex buffer isn't one");
+  }
+
+  if (command.IndexBuffer)
+  {
+    Object* buffer = GetObject(command.IndexBuffer, ObjectType::Buffer, "Submit");
+    if (buffer)
+      Check(buffer->Buffer == BufferType::Index, "Submit", "index buffer isn't one");
+  }
+
+  Check(command.VertexOffsets.size() <= command.VertexBuffers.size(), "Submit",
+        "more vertex offsets than vertex buffers");
+}
+
+void NullDevice::PushConstants(const void* data, std::size_t size)
+{
+  counters.PushConstants++;
+  counters.PushConstantBytes += size;
+  if (size > MaxPushConstantSize)
+    Report("PushConstants", std::to_string(size) + " bytes is over the limit");
+}
+
+ID NullDevice::CreateComputePipeline(const ComputePipelineDesc& desc)
+{
+  Object pipeline = {ObjectType::ComputePipeline};
+  for (const ShaderSPIRV& kernel : desc.ComputeKernels)
+    pipeline.Kernels.push_back(kernel.Name);
+
+  Check(!pipeline.Kernels.empty(), "CreateComputePipeline", "no kernels given");
+  return AddObject(pipeline);
+}
+
+void NullDevice::DestroyComputePipeline(ID id)
+{
+  DestroyObject(id, ObjectType::ComputePipeline, "DestroyComputePipeline");
+}
+
+void NullDevice::BeginComputePass()
+{
+  Check(commandBufferActive, "BeginComputePass", "no command buffer is active");
+  Check(!activePass && !computePass, "BeginComputePass", "another pass is active");
+  computePass = true;
+}
+
+void NullDevice::EndComputePass()
+{
+  Check(computePass, "EndComputePass", "no compute pass is active");
+  computePass = false;
+}
+
+void NullDevice::BindImage2D(ID texture, std::size_t binding, ImageAccess access)
+{
+  counters.Binds++;
+  Check(computePass, "BindImage2D", "no compute pass is active");
+  GetObject(texture, ObjectType::Texture2D, "BindImage2D");
+}
+
+void NullDevice::DispatchCompute(ID id, const std::string& kernel, const glm::ivec3& threadgroups)
+{
+  counters.Dispatches++;
+  Check(computePass, "DispatchCompute", "no compute pass is active");
+
+  Object* pipeline = GetObject(id, ObjectType::ComputePipeline, "DispatchCompute");
+  if (!pipeline)
+    return;
+
+  bool found = false;
+  for (const std::string& name : pipeline->Kernels)
+    found |= (name == kernel);
+  if (!found)
+    Report("DispatchCompute", "the pipeline has no kernel named " + kernel);
+}
+
+} // namespace Vision
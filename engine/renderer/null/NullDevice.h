@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "renderer/RenderDevice.h"
+
+namespace Vision
+{
+
+// A device that never touches a GPU. Every call is checked against the objects it has handed out
+// and the pass that is active, then counted, so the CPU cost of the renderers can be profiled and
+// regression tested on machines without one. Mistakes are reported to stdout and counted rather
+// than asserted, so a benchmark always runs to completion.
+class NullDevice : public RenderDevice
+{
+public:
+  struct Counters
+  {
+    std::size_t Draws = 0;
+    std::size_t Vertices = 0; // or indices, for indexed draws
+    std::size_t Dispatches = 0;
+    std::size_t PushConstants = 0;
+    std::size_t PushConstantBytes = 0;
+    std::size_t BufferUploads = 0;
+    std::size_t BufferBytes = 0;
+    std::size_t TextureUploads = 0;
+    std::size_t Binds = 0; // buffers, textures, cubemaps and images
+    std::size_t StateChanges = 0; // viewports and scissor rects
+    std::size_t RenderPasses = 0;
+    std::size_t CommandBuffers = 0;
+    std::size_t ObjectsCreated = 0;
+    std::size_t ObjectsDestroyed = 0;
+    std::size_t Errors = 0;
+  };
+
+  NullDevice(float width, float height);
+  ~NullDevice();
+
+  ID CreateRenderPipeline(const RenderPipelineDesc& desc);
+  void DestroyPipeline(ID id);
+
+  ID CreateBuffer(const BufferDesc& desc);
+  void SetBufferData(ID buffer, void* data, std::size_t size, std::size_t offset = 0);
+  void MapBufferData(ID buffer, void** data, std::size_t size);
+  void FreeBufferData(ID id, void** data);
+  void ResizeBuffer(ID buffer, std::size_t size);
+  void BindBuffer(ID buffer, std::size_t binding = 0, std::size_t offset = 0,
+                  std::size_t range = 0);
+  void DestroyBuffer(ID id);
+
+  ID CreateTexture2D(const Texture2DDesc& desc);
+  void ResizeTexture2D(ID id, float width, float height);
+  void SetTexture2DData(ID id, uint8_t* data);
+  void SetTexture2DDataRaw(ID id, void* data);
+  void BindTexture2D(ID id, std::size_t binding = 0);
+  void DestroyTexture2D(ID id);
+
+  ID CreateCubemap(const CubemapDesc& desc);
+  void BindCubemap(ID id, std::size_t binding = 0);
+  void DestroyCubemap(ID id);
+
+  ID CreateFramebuffer(const FramebufferDesc& desc);
+  ID GetFramebufferColorTex(ID id);
+  ID GetFramebufferDepthTex(ID id);
+  void ResizeFramebuffer(ID id, float width, float height);
+  void DestroyFramebuffer(ID id);
+
+  ID CreateRenderPass(const RenderPassDesc& desc);
+  void BeginRenderPass(ID pass);
+  void EndRenderPass();
+  void DestroyRenderPass(ID pass);
+
+  void BeginCommandBuffer();
+  void SubmitCommandBuffer(bool await = false);
+
+  void BufferBarrier() {}
+  void ImageBarrier() {}
+
+  void SchedulePresentation();
+
+  void SetViewport(float x, float y, float width, float height);
+  void SetScissorRect(float x, float y, float width, float height);
+  void Submit(const DrawCommand& command);
+  using RenderDevice::Submit;
+  void PushConstants(const void* data, std::size_t size);
+
+  ID CreateComputePipeline(const ComputePipelineDesc& desc);
+  void DestroyComputePipeline(ID id);
+
+  void BeginComputePass();
+  void EndComputePass();
+
+  void BindImage2D(ID texture, std::size_t binding = 0,
+                   ImageAccess access = ImageAccess::ReadWrite);
+
+  void DispatchCompute(ID pipeline, const std::string& kernel, const glm::ivec3& threadgroups);
+
+  RenderAPI GetRenderAPI() const { return RenderAPI::None; }
+
+  const Counters& GetCounters() const { return counters; }
+  void ResetCounters() { counters = Counters(); }
+  std::size_t GetNumObjects() const { return objects.size(); }
+
+  void Resize(float w, float h)
+  {
+    width = w;
+    height = h;
+  }
+
+private:
+  enum class ObjectType
+  {
+    RenderPipeline,
+    ComputePipeline,
+    Buffer,
+    Texture2D,
+    Cubemap,
+    Framebuffer,
+    RenderPass
+  };
+
+  struct Object
+  {
+    ObjectType Type;
+
+    std::size_t Size = 0;                    // buffers, in bytes
+    BufferType Buffer = BufferType::Vertex;  // buffers
+    std::size_t NumLayouts = 0;              // render pipelines, zero if derived from the shader
+    ID ColorTexture = 0, DepthTexture = 0;   // framebuffers
+    std::vector<std::string> Kernels;        // compute pipelines
+  };
+
+  static const char* ObjectTypeToString(ObjectType type);
+  ID AddObject(const Object& object);
+  Object* GetObject(ID id, ObjectType type, const char* call);
+  void DestroyObject(ID id, ObjectType type, const char* call);
+
+  // Counts and reports the error if the condition doesn't hold. Messages that have to be formatted
+  // go through Report directly, so nothing is built (or allocated) when the check passes.
+  bool Check(bool condition, const char* call, const char* message);
+  void Report(const char* call, const std::string& message);
+
+private:
+  std::unordered_map<ID, Object> objects;
+  std::size_t currentID = 1;
+  Counters counters;
+
+  // handed out by MapBufferData, since there is no memory to map
+  std::vector<std::uint8_t> mapping;
+
+  ID activePass = 0;
+  bool commandBufferActive = false;
+  bool computePass = false;
+
+  float width, height;
+};
+
+} // namespace Vision
@@ -1,23 +1,36 @@
 #include "GLBuffer.h"
 
 #include <SDL.h>
+#include <algorithm>
+#include <cstring>
 
 #include "GLTypes.h"
 
 namespace Vision
 {
 
-GLBuffer::GLBuffer(const BufferDesc& desc)
+static constexpr GLbitfield persistentMapFlags =
+    GL_MAP_WRITE_BIT | GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+GLBuffer::GLBuffer(const BufferDesc& desc, bool persistent)
     : type(BufferTypeToGLenum(desc.Type)), m_Usage(BufferUsageToGLenum(desc.Usage)),
       m_Size(desc.Size), debugName(desc.DebugName)
 {
   glGenBuffers(1, &m_Object);
   glBindBuffer(type, m_Object);
+
+  if (persistent)
+  {
+    CreateStorage(desc.Data);
+    return;
+  }
+
   glBufferData(type, m_Size, desc.Data, m_Usage);
 }
 
 GLBuffer::~GLBuffer()
 {
+  DestroyStorage();
   glDeleteBuffers(1, &m_Object);
 }
 
@@ -25,8 +38,36 @@ void GLBuffer::SetData(void* data, std::size_t size, std::size_t offset)
 {
   SDL_assert(size + offset <= m_Size);
 
-  glBindBuffer(type, m_Object);
-  glBufferSubData(type, offset, size, data);
+  if (!mapping)
+  {
+    glBindBuffer(type, m_Object);
+    glBufferSubData(type, offset, size, data);
+    return;
+  }
+
+  // Writing over bytes written since the region became current could change what the GPU reads
+  bool overlaps = offset < writtenEnd && offset + size > writtenBegin;
+  if (overlaps && !AdvanceRegion())
+  {
+    // The next region is still in use, so let the driver take care of it, as before
+    glBindBuffer(type, m_Object);
+    glBufferSubData(type, GetRegionOffset() + offset, size, data);
+  }
+  else
+  {
+    std::memcpy(mapping + GetRegionOffset() + offset, data, size);
+  }
+
+  if (writtenBegin == writtenEnd)
+  {
+    writtenBegin = offset;
+    writtenEnd = offset + size;
+  }
+  else
+  {
+    writtenBegin = std::min(writtenBegin, offset);
+    writtenEnd = std::max(writtenEnd, offset + size);
+  }
 }
 
 void GLBuffer::Resize(std::size_t size)
@@ -35,13 +76,52 @@ void GLBuffer::Resize(std::size_t size)
     return; // Don't worry about shrinking
 
   m_Size = size;
+
+  // Immutable storage can't be resized, so a new buffer takes its place
+  if (mapping)
+  {
+    DestroyStorage();
+    glDeleteBuffers(1, &m_Object);
+    glGenBuffers(1, &m_Object);
+    glBindBuffer(type, m_Object);
+    CreateStorage(nullptr);
+    return;
+  }
+
   glBindBuffer(type, m_Object);
   glBufferData(type, m_Size, nullptr, m_Usage);
 }
 
 void GLBuffer::Attach(std::size_t block, std::size_t offset, std::size_t size)
 {
-  glBindBufferRange(type, block, m_Object, offset, size == 0 ? m_Size : size);
+  glBindBufferRange(type, block, m_Object, GetRegionOffset() + offset, size == 0 ? m_Size : size);
+}
+
+void* GLBuffer::Map()
+{
+  if (!mapping)
+  {
+    glBindBuffer(type, m_Object);
+    return glMapBuffer(type, GL_READ_ONLY);
+  }
+
+  // Shader writes only reach a persistent mapping after a barrier, and the fence waits for them
+  glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+  GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+    ;
+  glDeleteSync(fence);
+
+  return mapping + GetRegionOffset();
+}
+
+void GLBuffer::Unmap()
+{
+  if (mapping)
+    return; // stays mapped
+
+  glBindBuffer(type, m_Object);
+  glUnmapBuffer(type);
 }
 
 void GLBuffer::Bind()
@@ -49,4 +129,62 @@ void GLBuffer::Bind()
   glBindBuffer(type, m_Object);
 }
 
+// Expects the buffer to be bound
+void GLBuffer::CreateStorage(const void* data)
+{
+  regionSize = (m_Size + regionAlignment - 1) / regionAlignment * regionAlignment;
+  std::size_t storageSize = regionSize * numRegions;
+
+  glBufferStorage(type, storageSize, nullptr, persistentMapFlags | GL_DYNAMIC_STORAGE_BIT);
+  mapping = static_cast<std::uint8_t*>(glMapBufferRange(type, 0, storageSize, persistentMapFlags));
+  SDL_assert(mapping);
+
+  // Every region starts with the data, like MetalBuffer's buffers do
+  region = 0;
+  writtenBegin = writtenEnd = 0;
+  if (data)
+  {
+    for (std::size_t i = 0; i < numRegions; i++)
+      std::memcpy(mapping + i * regionSize, data, m_Size);
+    writtenEnd = m_Size;
+  }
+}
+
+void GLBuffer::DestroyStorage()
+{
+  for (GLsync& fence : fences)
+  {
+    if (fence)
+      glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  if (mapping)
+  {
+    glBindBuffer(type, m_Object);
+    glUnmapBuffer(type);
+    mapping = nullptr;
+  }
+}
+
+bool GLBuffer::AdvanceRegion()
+{
+  std::size_t next = (region + 1) % numRegions;
+  if (fences[next])
+  {
+    GLenum status = glClientWaitSync(fences[next], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+      return false;
+
+    glDeleteSync(fences[next]);
+    fences[next] = nullptr;
+  }
+
+  // Everything that reads the current region has been issued by now
+  fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  region = next;
+  writtenBegin = writtenEnd = 0;
+  return true;
+}
+
 } // namespace Vision
\ No newline at end of file
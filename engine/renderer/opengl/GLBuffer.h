@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <glad/glad.h>
 
 #include "renderer/primitive/Buffer.h"
@@ -8,32 +9,63 @@
 namespace Vision
 {
 
+// Persistent buffers (dynamic buffers on GL 4.4+) stay mapped, and their storage is split into
+// regions, like MetalBuffer keeps a buffer per frame in flight. A write that would overwrite data
+// the GPU may still read moves on to the next region if the fence guarding it has signaled, so
+// uploads are a plain memcpy. Draws have to add GetRegionOffset to any offset into the buffer.
 class GLBuffer
 {
   friend class GLProgram;
 
 public:
-  GLBuffer(const BufferDesc& desc);
+  GLBuffer(const BufferDesc& desc, bool persistent = false);
   ~GLBuffer();
 
   GLuint GetID() const { return m_Object; }
   GLenum GetType() const { return type; }
+  std::size_t GetSize() const { return m_Size; }
   const BufferLayout& GetLayout() const { return m_Layout; }
 
+  bool IsPersistent() const { return mapping != nullptr; }
+  std::size_t GetRegion() const { return region; }
+  std::size_t GetRegionOffset() const { return region * regionSize; }
+
   void SetLayout(const BufferLayout& layout) { m_Layout = layout; }
   void SetData(void* data, std::size_t size, std::size_t offset);
-  void Resize(std::size_t size); // Resizes but doesn't give data to gpu
+  void Resize(std::size_t size); // Resizes but doesn't give data to gpu. May change the GL name.
   void Attach(std::size_t block, std::size_t offset, std::size_t size);
 
+  // Returns the contents for reading, waiting for the GPU if the buffer is persistent
+  void* Map();
+  void Unmap();
+
   void Bind();
 
 private:
+  void CreateStorage(const void* data);
+  void DestroyStorage();
+
+  // Fences the current region and moves to the next, unless the GPU is still using it
+  bool AdvanceRegion();
+
+private:
+  static constexpr std::size_t numRegions = 3;
+  static constexpr std::size_t regionAlignment = 256; // covers UBO and SSBO offset alignment
+
   GLuint m_Object;
   GLenum m_Usage;
   GLenum type;
   std::size_t m_Size;
   BufferLayout m_Layout;
 
+  std::uint8_t* mapping = nullptr;
+  std::size_t regionSize = 0;
+  std::size_t region = 0;
+  GLsync fences[numRegions] = {};
+
+  // the bytes written to the current region since it became current
+  std::size_t writtenBegin = 0, writtenEnd = 0;
+
   std::string debugName;
 };
 
@@ -0,0 +1,331 @@
+#include "GLCommandList.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "core/Hash.h"
+
+namespace Vision
+{
+
+enum SortPhase : std::uint64_t
+{
+  PhaseBegin = 0,
+  PhaseSorted = 1,
+  PhaseOrdered = 2,
+  PhaseEnd = 3
+};
+
+static std::uint64_t MakeKey(std::size_t pass, SortPhase phase, std::uint64_t rest = 0)
+{
+  return (static_cast<std::uint64_t>(pass) << 56) | (static_cast<std::uint64_t>(phase) << 54) |
+         (rest & ((1ull << 54) - 1));
+}
+
+// The bits of a non-negative float sort like the float does, so the top ones quantize it.
+static std::uint64_t DepthBits(float depth)
+{
+  std::uint32_t bits;
+  depth = std::max(depth, 0.0f);
+  std::memcpy(&bits, &depth, sizeof(bits));
+  return bits >> 18;
+}
+
+void GLCommandList::BindTexture(ID texture, std::size_t unit, bool cubemap)
+{
+  dirty = true;
+  for (TextureBinding& binding : textures)
+  {
+    if (binding.Unit == unit && binding.Cubemap == cubemap)
+    {
+      binding.Texture = texture;
+      return;
+    }
+  }
+
+  textures.push_back({texture, static_cast<std::uint32_t>(unit), cubemap});
+}
+
+void GLCommandList::BindBuffer(ID buffer, std::size_t block, std::size_t offset, std::size_t size)
+{
+  dirty = true;
+  for (BufferBinding& binding : buffers)
+  {
+    if (binding.Block == block)
+    {
+      binding = {buffer, block, offset, size};
+      return;
+    }
+  }
+
+  buffers.push_back({buffer, block, offset, size});
+}
+
+void GLCommandList::SetPushConstants(const void* data, std::size_t size)
+{
+  dirty = true;
+  const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+  pushConstants.assign(bytes, bytes + size);
+  current.PushConstantSize = static_cast<std::uint32_t>(size);
+  current.PushConstantVersion++;
+}
+
+void GLCommandList::SetViewport(const glm::vec4& viewport)
+{
+  dirty = true;
+  current.HasViewport = true;
+  current.Viewport = viewport;
+}
+
+void GLCommandList::SetScissor(const glm::vec4& scissor)
+{
+  dirty = true;
+  current.HasScissor = true;
+  current.Scissor = scissor;
+}
+
+void GLCommandList::ForgetTexture(ID texture)
+{
+  dirty = true;
+  std::erase_if(textures, [texture](const TextureBinding& binding)
+                { return binding.Texture == texture; });
+}
+
+void GLCommandList::ForgetBuffer(ID buffer)
+{
+  dirty = true;
+  std::erase_if(buffers, [buffer](const BufferBinding& binding)
+                { return binding.Buffer == buffer; });
+}
+
+void GLCommandList::BeginPass(ID pass, bool preserve)
+{
+  preserveOrder = preserve;
+
+  Command command;
+  command.Type = CommandType::BeginPass;
+  command.Pass = pass;
+  AddCommand(MakeKey(numPasses, PhaseBegin), command, {});
+}
+
+void GLCommandList::EndPass(ID pass)
+{
+  Command command;
+  command.Type = CommandType::EndPass;
+  command.Pass = pass;
+  AddCommand(MakeKey(numPasses, PhaseEnd), command, {});
+  numPasses++;
+
+  dirty = true;
+  current.HasScissor = false;
+}
+
+void GLCommandList::Draw(const DrawCommand& draw, bool ordered)
+{
+  Command command;
+  command.Type = CommandType::Draw;
+  command.Bindings = CaptureBindings();
+  command.Pipeline = draw.RenderPipeline;
+  command.IndexBuffer = draw.IndexBuffer;
+  command.Primitive = draw.Type;
+  command.Indices = draw.IndexType;
+  command.HasVertexOffset = !draw.VertexOffsets.empty();
+  command.NumVertices = draw.NumVertices;
+  command.IndexOffset = draw.IndexOffset;
+  command.VertexOffset = command.HasVertexOffset ? draw.VertexOffsets[0] : 0;
+
+  std::uint64_t key;
+  if (ordered || preserveOrder)
+  {
+    key = MakeKey(numPasses, PhaseOrdered, sequence);
+  }
+  else
+  {
+    ID vertexBuffer = draw.VertexBuffers.empty() ? 0 : draw.VertexBuffers[0];
+    std::uint64_t pipeline = pipelineIndices.Get(draw.RenderPipeline);
+    std::uint64_t textureSet = textureIndices.Get(textureHash);
+    std::uint64_t buffer = bufferIndices.Get(vertexBuffer);
+    key = MakeKey(numPasses, PhaseSorted,
+                  ((pipeline & 0x3fff) << 40) | ((textureSet & 0x3fff) << 26) |
+                      ((buffer & 0xfff) << 14) | DepthBits(draw.SortDepth));
+  }
+  sequence++;
+
+  AddCommand(key, command, draw.VertexBuffers);
+}
+
+// An LSD radix sort a byte at a time, which is stable. Bytes every key shares are skipped, which
+// is most of them in a typical frame.
+void GLCommandList::Sort()
+{
+  std::size_t count = entries.size();
+  if (count < 2)
+    return;
+
+  scratch.resize(count);
+
+  for (std::size_t shift = 0; shift < 64; shift += 8)
+  {
+    std::size_t offsets[256] = {};
+    for (const Entry& entry : entries)
+      offsets[(entry.Key >> shift) & 0xff]++;
+
+    if (offsets[(entries[0].Key >> shift) & 0xff] == count)
+      continue;
+
+    std::size_t total = 0;
+    for (std::size_t& offset : offsets)
+    {
+      std::size_t bucket = offset;
+      offset = total;
+      total += bucket;
+    }
+
+    for (const Entry& entry : entries)
+      scratch[offsets[(entry.Key >> shift) & 0xff]++] = entry;
+    entries.swap(scratch);
+  }
+}
+
+std::span<const ID> GLCommandList::GetVertexBuffers(const Command& command) const
+{
+  const std::uint8_t* end = reinterpret_cast<const std::uint8_t*>(&command) + sizeof(Command);
+  return {reinterpret_cast<const ID*>(end), command.NumVertexBuffers};
+}
+
+std::span<const GLCommandList::TextureBinding>
+GLCommandList::GetTextures(const Bindings& bindings) const
+{
+  const std::uint8_t* end = reinterpret_cast<const std::uint8_t*>(&bindings) + sizeof(Bindings);
+  return {reinterpret_cast<const TextureBinding*>(end), bindings.NumTextures};
+}
+
+std::span<const GLCommandList::BufferBinding>
+GLCommandList::GetBuffers(const Bindings& bindings) const
+{
+  std::span<const TextureBinding> textureBindings = GetTextures(bindings);
+  const std::uint8_t* end = reinterpret_cast<const std::uint8_t*>(
+      textureBindings.data() + textureBindings.size());
+  return {reinterpret_cast<const BufferBinding*>(end), bindings.NumBuffers};
+}
+
+const void* GLCommandList::GetPushConstants(const Bindings& bindings) const
+{
+  std::span<const BufferBinding> bufferBindings = GetBuffers(bindings);
+  return bufferBindings.data() + bufferBindings.size();
+}
+
+void GLCommandList::Clear()
+{
+  arenaSize = 0;
+  entries.clear();
+  numPasses = 0;
+  sequence = 0;
+  dirty = true; // the snapshot went with the arena
+
+  pipelineIndices.Clear();
+  textureIndices.Clear();
+  bufferIndices.Clear();
+}
+
+std::size_t GLCommandList::Write(const void* data, std::size_t size)
+{
+  std::size_t offset = arenaSize;
+  std::size_t words = (size + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+  arenaSize += words * sizeof(std::uint64_t);
+  if (arenaSize > arena.size() * sizeof(std::uint64_t))
+    arena.resize(std::max(arena.size() * 2, arenaSize / sizeof(std::uint64_t)));
+
+  if (size)
+    std::memcpy(reinterpret_cast<std::uint8_t*>(arena.data()) + offset, data, size);
+  return offset;
+}
+
+std::size_t GLCommandList::CaptureBindings()
+{
+  if (!dirty)
+    return currentOffset;
+
+  std::uint64_t hash = HashSeed;
+  for (const TextureBinding& binding : textures)
+  {
+    hash = Hash64Value(binding.Texture, hash);
+    hash = Hash64Value(binding.Unit, hash);
+    hash = Hash64Value(binding.Cubemap, hash);
+  }
+  textureHash = textures.empty() ? 0 : hash;
+
+  // Every part is a multiple of 8 bytes, so they are laid out back to back
+  current.NumTextures = static_cast<std::uint32_t>(textures.size());
+  current.NumBuffers = static_cast<std::uint32_t>(buffers.size());
+  currentOffset = Write(&current, sizeof(Bindings));
+  Write(textures.data(), textures.size() * sizeof(TextureBinding));
+  Write(buffers.data(), buffers.size() * sizeof(BufferBinding));
+  Write(pushConstants.data(), pushConstants.size());
+
+  dirty = false;
+  return currentOffset;
+}
+
+std::uint64_t GLCommandList::DenseIndices::Get(std::uint64_t value)
+{
+  if ((count + 1) * 2 > keys.size())
+    Grow();
+
+  std::size_t mask = keys.size() - 1;
+  for (std::size_t slot = Hash64Value(value, HashSeed) & mask;; slot = (slot + 1) & mask)
+  {
+    if (indices[slot] == 0)
+    {
+      keys[slot] = value;
+      indices[slot] = ++count;
+      return count - 1;
+    }
+
+    if (keys[slot] == value)
+      return indices[slot] - 1;
+  }
+}
+
+void GLCommandList::DenseIndices::Clear()
+{
+  if (count == 0)
+    return;
+
+  std::fill(indices.begin(), indices.end(), 0);
+  count = 0;
+}
+
+void GLCommandList::DenseIndices::Grow()
+{
+  std::vector<std::uint64_t> oldKeys = std::move(keys);
+  std::vector<std::uint32_t> oldIndices = std::move(indices);
+  keys.assign(std::max<std::size_t>(64, oldKeys.size() * 2), 0);
+  indices.assign(keys.size(), 0);
+
+  std::size_t mask = keys.size() - 1;
+  for (std::size_t i = 0; i < oldKeys.size(); i++)
+  {
+    if (oldIndices[i] == 0)
+      continue;
+
+    std::size_t slot = Hash64Value(oldKeys[i], HashSeed) & mask;
+    while (indices[slot] != 0)
+      slot = (slot + 1) & mask;
+    keys[slot] = oldKeys[i];
+    indices[slot] = oldIndices[i];
+  }
+}
+
+void GLCommandList::AddCommand(std::uint64_t key, const Command& command,
+                               std::span<const ID> vertexBuffers)
+{
+  Command stored = command;
+  stored.NumVertexBuffers = static_cast<std::uint32_t>(vertexBuffers.size());
+
+  std::size_t offset = Write(&stored, sizeof(Command));
+  Write(vertexBuffers.data(), vertexBuffers.size_bytes());
+  entries.push_back({key, offset});
+}
+
+} // namespace Vision
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+#include "renderer/RenderCommand.h"
+
+namespace Vision
+{
+
+// The commands GLDevice records between BeginCommandBuffer and SubmitCommandBuffer. Everything is
+// copied into one arena that is reused every frame, and each command gets a 64-bit sort key:
+//
+//   pass (8) | phase (2) | pipeline (14) | textures (14) | vertex buffer (12) | depth (14)
+//
+// Pipelines, texture sets and vertex buffers are numbered in the order a frame first uses them, so
+// their fields don't alias however large the IDs get.
+//
+// Sorting groups draws that share state, so replaying them through the state cache issues far
+// fewer GL calls. Draws that blend, or are in a pass that preserves order, use the ordered phase
+// instead, where the rest of the key is just their submission order.
+//
+// Draws don't read the bindings when they are replayed, so each keeps a snapshot of the bindings
+// (textures, buffers, push constants, viewport and scissor) that were current when it was
+// recorded. Consecutive draws with no binding calls between them share one.
+class GLCommandList
+{
+public:
+  enum class CommandType : std::uint32_t
+  {
+    BeginPass,
+    EndPass,
+    Draw
+  };
+
+  struct Command
+  {
+    CommandType Type;
+    std::uint32_t NumVertexBuffers = 0; // stored right after the command
+    std::size_t Bindings = 0;           // arena offset of the draw's Bindings
+    ID Pass = 0;
+
+    ID Pipeline = 0;
+    ID IndexBuffer = 0;
+    PrimitiveType Primitive = PrimitiveType::Triangle;
+    IndexType Indices = IndexType::U32;
+    bool HasVertexOffset = false;
+    std::size_t NumVertices = 0;
+    std::size_t IndexOffset = 0;
+    std::size_t VertexOffset = 0;
+  };
+
+  struct TextureBinding
+  {
+    ID Texture;
+    std::uint32_t Unit;
+    bool Cubemap;
+  };
+
+  struct BufferBinding
+  {
+    ID Buffer;
+    std::size_t Block, Offset, Size;
+  };
+
+  // Followed in the arena by its textures, buffers and push constant data
+  struct Bindings
+  {
+    std::uint32_t NumTextures = 0, NumBuffers = 0;
+    std::uint32_t PushConstantSize = 0;
+    std::uint64_t PushConstantVersion = 0; // changes with every PushConstants call
+    bool HasViewport = false, HasScissor = false;
+    glm::vec4 Viewport, Scissor;
+  };
+
+  // The current bindings. These persist across command buffers, like GL state does.
+  void BindTexture(ID texture, std::size_t unit, bool cubemap);
+  void BindBuffer(ID buffer, std::size_t block, std::size_t offset, std::size_t size);
+  void SetPushConstants(const void* data, std::size_t size);
+  void SetViewport(const glm::vec4& viewport);
+  void SetScissor(const glm::vec4& scissor);
+  void ForgetTexture(ID texture);
+  void ForgetBuffer(ID buffer);
+
+  std::uint64_t GetPushConstantVersion() const { return current.PushConstantVersion; }
+
+  bool CanBeginPass() const { return numPasses < maxPasses; }
+  void BeginPass(ID pass, bool preserveOrder);
+  void EndPass(ID pass); // scissor rects don't outlive their pass
+  void Draw(const DrawCommand& command, bool ordered);
+
+  // Writes the current bindings to the arena if they changed since the last time, returning them
+  std::size_t CaptureBindings();
+
+  bool IsEmpty() const { return entries.empty(); }
+
+  // Sorts the commands by key. Equal keys stay in submission order.
+  void Sort();
+
+  std::size_t GetNumCommands() const { return entries.size(); }
+  const Command& GetCommand(std::size_t index) const
+  {
+    return *Get<Command>(entries[index].Offset);
+  }
+  std::span<const ID> GetVertexBuffers(const Command& command) const;
+
+  const Bindings& GetBindings(std::size_t offset) const { return *Get<Bindings>(offset); }
+  std::span<const TextureBinding> GetTextures(const Bindings& bindings) const;
+  std::span<const BufferBinding> GetBuffers(const Bindings& bindings) const;
+  const void* GetPushConstants(const Bindings& bindings) const;
+
+  // Drops the commands, but keeps the memory and the current bindings
+  void Clear();
+
+private:
+  struct Entry
+  {
+    std::uint64_t Key;
+    std::size_t Offset;
+  };
+
+  // Copies the data into the arena, returning its offset
+  std::size_t Write(const void* data, std::size_t size);
+  template <typename T> const T* Get(std::size_t offset) const
+  {
+    return reinterpret_cast<const T*>(reinterpret_cast<const std::uint8_t*>(arena.data()) + offset);
+  }
+
+  void AddCommand(std::uint64_t key, const Command& command, std::span<const ID> vertexBuffers);
+
+  // Numbers values 0, 1, 2... in the order they are first seen. Open addressed, so clearing it
+  // every frame keeps its memory.
+  class DenseIndices
+  {
+  public:
+    std::uint64_t Get(std::uint64_t value);
+    void Clear();
+
+  private:
+    void Grow();
+
+  private:
+    std::vector<std::uint64_t> keys;
+    std::vector<std::uint32_t> indices; // index + 1, zero marks an empty slot
+    std::uint32_t count = 0;
+  };
+
+private:
+  static constexpr std::size_t maxPasses = 256;
+
+  // 8 byte words, so everything written is aligned
+  std::vector<std::uint64_t> arena;
+  std::size_t arenaSize = 0;
+
+  std::vector<Entry> entries, scratch;
+
+  // current bindings, written to the arena when a draw needs them
+  std::vector<TextureBinding> textures;
+  std::vector<BufferBinding> buffers;
+  std::vector<std::uint8_t> pushConstants;
+  Bindings current;
+  std::size_t currentOffset = 0;
+  std::uint64_t textureHash = 0;
+  bool dirty = true;
+
+  DenseIndices pipelineIndices, textureIndices, bufferIndices;
+
+  std::size_t numPasses = 0;
+  bool preserveOrder = false;
+  std::uint64_t sequence = 0;
+};
+
+} // namespace Vision
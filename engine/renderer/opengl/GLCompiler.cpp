@@ -1,26 +1,52 @@
 #include "GLCompiler.h"
 
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <spirv_glsl.hpp>
+#include <thread>
+
+#include "core/Hash.h"
+#include "renderer/shader/ShaderReflector.h"
 
 #include "GLTypes.h"
 
 namespace Vision
 {
 
-GLuint GLCompiler::Compile(const ShaderSPIRV& shader, uint32_t version)
+// Bump whenever the decompiler setup changes (spirv-cross options, entry layout).
+constexpr std::uint32_t glslCacheVersion = 2;
+constexpr std::uint32_t glslCacheMagic = 0x534c4756; // "VGLS"
+
+struct GLSLCacheHeader
+{
+  std::uint32_t Magic;
+  std::uint32_t Version;
+  std::uint64_t Key;
+  std::uint64_t PayloadHash;
+  std::uint64_t Length;
+};
+
+GLCompiler::GLCompiler(const std::string& cacheDirectory)
+    : directory(cacheDirectory)
 {
-  // We'd love to directly send the SPIRV to the GPU. However, AMD drivers for OpenGL have bugs
-  // which seem to have existed since launch for this feature. We'll have to decompile and
-  // recompile. Hopefully, this isn't a huge bottleneck in our shader pipeline.
-  spirv_cross::CompilerGLSL decompiler(shader.SPIRV);
+  if (directory.empty())
+    return;
 
-  spirv_cross::CompilerGLSL::Options options;
-  options.version = version;
-  options.enable_420pack_extension = false;
-  decompiler.set_common_options(options);
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error)
+  {
+    std::cout << "Warning: unable to create GLSL cache folder " << directory << std::endl;
+    directory.clear();
+  }
+}
 
-  std::string glsl = decompiler.compile();
+GLuint GLCompiler::Compile(const ShaderSPIRV& shader, uint32_t version, bool wait,
+                           const std::vector<SpecializationConstant>& constants)
+{
+  std::string glsl = Decompile(shader, version, constants);
   const char* c_str = glsl.c_str();
 
   // Create the shader
@@ -28,20 +54,133 @@ GLuint GLCompiler::Compile(const ShaderSPIRV& shader, uint32_t version)
   glShaderSource(shaderID, 1, &c_str, nullptr);
   glCompileShader(shaderID);
 
+  if (wait && LogCompileErrors(shaderID, shader))
+  {
+    glDeleteShader(shaderID);
+    return 0;
+  }
+
+  return shaderID;
+}
+
+bool GLCompiler::LogCompileErrors(GLuint shaderID, const ShaderSPIRV& shader)
+{
   int success;
   glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
-  if (!success)
+  if (success)
+    return false;
+
+  constexpr static std::size_t bufferSize = 512;
+  char infoLog[bufferSize];
+
+  glGetShaderInfoLog(shaderID, bufferSize, nullptr, infoLog);
+  std::cout << "Failed to compile shader: " << shader.Name << std::endl;
+  std::cout << infoLog << std::endl;
+  return true;
+}
+
+std::string GLCompiler::Decompile(const ShaderSPIRV& shader, uint32_t version,
+                                  const std::vector<SpecializationConstant>& constants)
+{
+  std::uint64_t key = ComputeKey(shader, version, constants);
   {
-    constexpr static std::size_t bufferSize = 512;
-    char infoLog[bufferSize];
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = sources.find(key);
+    if (it != sources.end())
+      return it->second;
+  }
 
-    glGetShaderInfoLog(shaderID, bufferSize, nullptr, infoLog);
-    std::cout << "Failed to compile shader: " << shader.Name << std::endl;
-    std::cout << infoLog << std::endl;
-    return 0;
+  std::string glsl;
+  if (directory.empty() || !LoadFromDisk(key, glsl))
+  {
+    // We'd love to directly send the SPIRV to the GPU. However, AMD drivers for OpenGL have bugs
+    // which seem to have existed since launch for this feature. We'll have to decompile and
+    // recompile. Hopefully, this isn't a huge bottleneck in our shader pipeline.
+    spirv_cross::CompilerGLSL decompiler(shader.GetCode().data(), shader.GetCode().size());
+
+    spirv_cross::CompilerGLSL::Options options;
+    options.version = version;
+    options.enable_420pack_extension = false;
+    options.emit_push_constant_as_uniform_buffer = true;
+    decompiler.set_common_options(options);
+    ApplySpecializationConstants(decompiler, constants);
+
+    // push_constant blocks become the uniform block at PushConstantBinding. The binding is only
+    // emitted with explicit bindings, GLProgram binds it by name otherwise.
+    spirv_cross::ShaderResources resources = decompiler.get_shader_resources();
+    for (const spirv_cross::Resource& block : resources.push_constant_buffers)
+      decompiler.set_decoration(block.id, spv::DecorationBinding, PushConstantBinding);
+
+    glsl = decompiler.compile();
+    if (!directory.empty())
+      StoreToDisk(key, glsl);
   }
 
-  return shaderID;
+  std::lock_guard<std::mutex> lock(mutex);
+  sources.emplace(key, glsl);
+  return glsl;
+}
+
+std::uint64_t GLCompiler::ComputeKey(const ShaderSPIRV& shader, uint32_t version,
+                                     const std::vector<SpecializationConstant>& constants)
+{
+  std::uint64_t key = Hash64Value(glslCacheVersion, HashSeed);
+  key = Hash64Value(version, key);
+  key = HashSpecialization(constants, key);
+  return Hash64(shader.GetCode().data(), shader.GetCode().size_bytes(), key);
+}
+
+bool GLCompiler::LoadFromDisk(std::uint64_t key, std::string& glsl) const
+{
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.glsl", static_cast<unsigned long long>(key));
+  std::ifstream file(directory + "/" + name, std::ios::binary | std::ios::in);
+  if (!file.is_open())
+    return false;
+
+  GLSLCacheHeader header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    return false;
+
+  if (header.Magic != glslCacheMagic || header.Version != glslCacheVersion || header.Key != key)
+    return false;
+
+  std::string data(header.Length, '\0');
+  if (!file.read(data.data(), data.size()) || Hash64(data) != header.PayloadHash)
+    return false;
+
+  glsl = std::move(data);
+  return true;
+}
+
+void GLCompiler::StoreToDisk(std::uint64_t key, const std::string& glsl) const
+{
+  GLSLCacheHeader header;
+  header.Magic = glslCacheMagic;
+  header.Version = glslCacheVersion;
+  header.Key = key;
+  header.PayloadHash = Hash64(glsl);
+  header.Length = glsl.size();
+
+  // Same write-then-rename dance as the SPIRV cache, so readers never see half an entry.
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.glsl", static_cast<unsigned long long>(key));
+  std::string path = directory + "/" + name;
+  std::size_t thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+  std::string tempPath = path + "." + std::to_string(thread) + ".tmp";
+  {
+    std::ofstream stream(tempPath, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!stream.is_open())
+      return;
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(glsl.data(), glsl.size());
+  }
+
+  std::error_code error;
+  std::filesystem::rename(tempPath, path, error);
+  if (error)
+    std::filesystem::remove(tempPath, error);
 }
 
-} // namespace Vision
\ No newline at end of file
+} // namespace Vision
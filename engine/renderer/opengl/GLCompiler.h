@@ -1,16 +1,49 @@
 #pragma once
 
+#include <cstdint>
 #include <glad/glad.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "renderer/shader/Shader.h"
 
 namespace Vision
 {
 
+// Turns SPIRV into GL shader objects by way of spirv-cross. Decompiled GLSL is cached by the hash
+// of the SPIRV, the target version and any specialization constants, so a shader shared between
+// pipelines (or seen on a previous run, when a cache directory is given) never goes through
+// spirv-cross twice.
 class GLCompiler
 {
 public:
-  GLuint Compile(const ShaderSPIRV& shaderSPIRV, uint32_t version = 450);
+  // An empty directory keeps the cache in memory only.
+  GLCompiler(const std::string& cacheDirectory = "");
+
+  // Without waiting, the compile status isn't checked so the driver may compile in the background.
+  // Errors then surface when the program is linked (see LogCompileErrors).
+  GLuint Compile(const ShaderSPIRV& shaderSPIRV, uint32_t version = 450, bool wait = true,
+                 const std::vector<SpecializationConstant>& constants = {});
+  static bool LogCompileErrors(GLuint shader, const ShaderSPIRV& shaderSPIRV);
+
+  // Safe to call from any thread, it doesn't touch the GL. GLSL has no specialization, so the
+  // constants are baked into the decompiled source.
+  std::string Decompile(const ShaderSPIRV& shaderSPIRV, uint32_t version = 450,
+                        const std::vector<SpecializationConstant>& constants = {});
+
+  static std::uint64_t ComputeKey(const ShaderSPIRV& shaderSPIRV, uint32_t version,
+                                  const std::vector<SpecializationConstant>& constants = {});
+
+private:
+  bool LoadFromDisk(std::uint64_t key, std::string& glsl) const;
+  void StoreToDisk(std::uint64_t key, const std::string& glsl) const;
+
+private:
+  std::mutex mutex;
+  std::unordered_map<std::uint64_t, std::string> sources;
+  std::string directory;
 };
 
-}
\ No newline at end of file
+} // namespace Vision
@@ -44,7 +44,7 @@ GLContext::GLContext(SDL_Window* wind)
   displayScale = SDL_GetWindowDisplayScale(window);
 
   // Instantiate our own GLDevice class handling resource management
-  device = new GLDevice(window, width, height);
+  device = new GLDevice(window, width, height, (GLADloadproc)SDL_GL_GetProcAddress);
 
   // Log the renderer info
   std::cout << "Created OpenGL Context: " << glGetString(GL_VERSION) << std::endl;
@@ -1,31 +1,208 @@
 #include "GLDevice.h"
 
 #include <SDL.h>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <spirv_glsl.hpp>
 
 #include "GLTypes.h"
 
+// KHR_parallel_shader_compile isn't part of our glad profile, so we load it by hand.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void(APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+#include "core/Hash.h"
+
 #include "renderer/shader/ShaderCompiler.h"
+#include "renderer/shader/ShaderReflector.h"
 
 namespace Vision
 {
 
-GLDevice::GLDevice(SDL_Window* wind, float w, float h): window(wind), width(w), height(h)
+constexpr std::size_t pushConstantRingSize = 256 * 1024;
+
+// Asks the GL rather than SDL, since headless contexts aren't created through SDL.
+static bool HasExtension(const char* name)
 {
-  gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress);
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+  for (GLint i = 0; i < count; i++)
+    if (std::strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), name) == 0)
+      return true;
+
+  return false;
+}
+
+GLDevice::GLDevice(SDL_Window* wind, float w, float h, GLADloadproc loader)
+    : window(wind), width(w), height(h), compiler("cache/glsl"), programCache("cache/glprogram")
+{
+  gladLoadGLLoader(loader);
 
   // Query the version of OpenGL that our context supports
   glGetIntegerv(GL_MAJOR_VERSION, &versionMajor);
   glGetIntegerv(GL_MINOR_VERSION, &versionMinor);
+
+  // Program binaries are core since 4.1
+  if (versionMajor > 4 || (versionMajor == 4 && versionMinor >= 1))
+    programCache.Initialize();
+
+  // Dynamic buffers are persistently mapped rings when buffer storage is available
+  persistentBuffers = versionMajor > 4 || (versionMajor == 4 && versionMinor >= 4);
+
+  // Let the driver compile and link on its own threads, so async pipelines can be polled
+  if (HasExtension("GL_KHR_parallel_shader_compile"))
+  {
+    auto maxCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(
+        loader("glMaxShaderCompilerThreadsKHR"));
+    if (maxCompilerThreads)
+    {
+      maxCompilerThreads(0xFFFFFFFF); // as many as the driver wants
+      parallelShaderCompile = true;
+    }
+  }
+
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+  glGenBuffers(1, &pushConstantBuffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, pushConstantBuffer);
+  glBufferData(GL_UNIFORM_BUFFER, pushConstantRingSize, nullptr, GL_STREAM_DRAW);
+}
+
+GLDevice::~GLDevice()
+{
+  // The workers reference the compiler, so let them finish before anything is torn down.
+  pipelineWorkers.Wait();
+
+  if (programCache.IsEnabled())
+    std::cout << "Program binary cache: " << programCache.GetHits() << " hits, "
+              << programCache.GetMisses() << " misses (" << programCache.GetRejected()
+              << " rejected by the driver)" << std::endl;
+
+  for (auto& pair : sharedPrograms)
+    delete pair.second.Program;
+
+  glDeleteBuffers(1, &pushConstantBuffer);
 }
 
 ID GLDevice::CreateRenderPipeline(const RenderPipelineDesc& desc)
+{
+  GLPipeline* pipeline = CreatePipelineState(desc);
+  if (ID existing = ShareExistingPipeline(pipeline))
+  {
+    // the match may be an async pipeline that is still building, but this caller expects it ready
+    auto pending = pendingPipelines.find(existing);
+    if (pending != pendingPipelines.end())
+    {
+      AdvancePendingPipeline(pending->first, pending->second, true);
+      pendingPipelines.erase(pending);
+    }
+
+    return existing;
+  }
+
+  pipeline->Program = AcquireProgram(desc.VertexShader, desc.PixelShader, desc.Constants, true,
+                                     pipeline->ProgramKey);
+
+  ID id = currentID++;
+  pipelines.Add(id, pipeline);
+  pipelineStates[pipeline->StateKey] = id;
+  return id;
+}
+
+ID GLDevice::CreateRenderPipelineAsync(const RenderPipelineDesc& desc)
+{
+  GLPipeline* pipeline = CreatePipelineState(desc);
+  if (ID existing = ShareExistingPipeline(pipeline))
+    return existing;
+
+  // The pipeline exists right away, it just has no program until the build completes.
+  ID id = currentID++;
+  pipelines.Add(id, pipeline);
+  pipelineStates[pipeline->StateKey] = id;
+
+  // spirv-cross is the expensive CPU side of the build, and doesn't need the GL. Warm the
+  // compiler's cache on the workers so the render thread only has to hand GLSL to the driver.
+  uint32_t version = UsesManualBindings() ? 410 : 450;
+  std::uint64_t key =
+      programCache.ComputeKey({&desc.VertexShader, &desc.PixelShader}, version, desc.Constants);
+  bool built = sharedPrograms.contains(key);
+
+  PendingPipeline& pending = pendingPipelines[id];
+  pending.RenderDesc = desc;
+  pending.CPUWork = pipelineWorkers.Submit(
+      [this, key, built, version, vs = desc.VertexShader, fs = desc.PixelShader,
+       constants = desc.Constants]()
+      {
+        if (built || programCache.Contains(key))
+          return;
+
+        compiler.Decompile(vs, version, constants);
+        compiler.Decompile(fs, version, constants);
+      });
+
+  return id;
+}
+
+// Everything that makes two pipelines behave differently. Element names don't matter to GL, which
+// binds attributes by location.
+static std::uint64_t HashLayouts(const std::vector<BufferLayout>& layouts)
+{
+  std::uint64_t hash = HashSeed;
+  for (const BufferLayout& layout : layouts)
+  {
+    hash = Hash64Value(layout.Stride, hash);
+    for (const BufferElement& element : layout.Elements)
+    {
+      hash = Hash64Value(element.Type, hash);
+      hash = Hash64Value(element.Normalized, hash);
+      hash = Hash64Value(element.InstanceDivisor, hash);
+      hash = Hash64Value(element.Offset, hash);
+      hash = Hash64Value(element.Location, hash);
+    }
+  }
+
+  return Hash64Value(layouts.size(), hash);
+}
+
+static std::uint64_t HashPipelineState(const GLPipeline& pipeline)
+{
+  std::uint64_t hash = Hash64Value(pipeline.VertexHash, HashSeed);
+  hash = Hash64Value(pipeline.PixelHash, hash);
+  hash = HashSpecialization(pipeline.Constants, hash);
+  hash = Hash64Value(pipeline.LayoutHash, hash);
+  hash = Hash64Value(pipeline.DepthTest, hash);
+  hash = Hash64Value(pipeline.DepthWrite, hash);
+  hash = Hash64Value(pipeline.DepthFunc, hash);
+  hash = Hash64Value(pipeline.FillMode, hash);
+  hash = Hash64Value(pipeline.EnableBlend, hash);
+  hash = Hash64Value(pipeline.BlendSource, hash);
+  return Hash64Value(pipeline.BlendDst, hash);
+}
+
+GLPipeline* GLDevice::CreatePipelineState(const RenderPipelineDesc& desc)
 {
   GLPipeline* pipeline = new GLPipeline();
-  pipeline->Layouts = desc.Layouts;
-  pipeline->Program =
-      new GLProgram(desc.VertexShader, desc.PixelShader, versionMinor < 2 || versionMajor < 4);
+  std::shared_ptr<const ShaderReflection> reflection =
+      ShaderReflector::GetReflection(desc.VertexShader);
+  if (desc.DeriveLayout)
+    pipeline->Layouts = {BufferLayout::FromReflection(*reflection)};
+  else
+    pipeline->Layouts = desc.Layouts;
+
+#ifndef NDEBUG
+  ValidateBufferLayouts(pipeline->Layouts, *reflection, desc.VertexShader.Name);
+#endif
+  pipeline->LayoutHash = HashLayouts(pipeline->Layouts);
+
+  pipeline->Program = nullptr;
+
+  pipeline->VertexShader = desc.VertexShader;
+  pipeline->PixelShader = desc.PixelShader;
+  pipeline->VertexHash = desc.VertexShader.GetCodeHash();
+  pipeline->PixelHash = desc.PixelShader.GetCodeHash();
+  pipeline->Constants = desc.Constants;
 
   pipeline->DepthTest = desc.DepthTest;
   pipeline->DepthWrite = desc.DepthWrite;
@@ -37,34 +214,203 @@ ID GLDevice::CreateRenderPipeline(const RenderPipelineDesc& desc)
   pipeline->BlendSource = GL_SRC_ALPHA;
   pipeline->BlendDst = GL_ONE_MINUS_SRC_ALPHA;
 
-  ID id = currentID++;
-  pipelines.Add(id, pipeline);
-  return id;
+  pipeline->StateKey = HashPipelineState(*pipeline);
+  return pipeline;
+}
+
+// Returns the ID of a pipeline with the same state and takes a reference to it, deleting the new
+// one. Returns 0 if there is no such pipeline.
+ID GLDevice::ShareExistingPipeline(GLPipeline* pipeline)
+{
+  auto existing = pipelineStates.find(pipeline->StateKey);
+  if (existing == pipelineStates.end())
+    return 0;
+
+  delete pipeline;
+  pipelines.Get(existing->second)->References++;
+  return existing->second;
+}
+
+void GLDevice::ForgetPipelineState(ID id, const GLPipeline* pipeline)
+{
+  auto state = pipelineStates.find(pipeline->StateKey);
+  if (state != pipelineStates.end() && state->second == id)
+    pipelineStates.erase(state);
+}
+
+GLProgram* GLDevice::AcquireProgram(const ShaderSPIRV& vertexShader, const ShaderSPIRV& pixelShader,
+                                    const std::vector<SpecializationConstant>& constants,
+                                    bool waitForLink, std::uint64_t& key)
+{
+  uint32_t version = UsesManualBindings() ? 410 : 450;
+  key = programCache.ComputeKey({&vertexShader, &pixelShader}, version, constants);
+
+  auto shared = sharedPrograms.find(key);
+  if (shared != sharedPrograms.end())
+  {
+    shared->second.References++;
+    if (waitForLink)
+      shared->second.Program->FinishLink();
+    return shared->second.Program;
+  }
+
+  GLProgram* program = new GLProgram(compiler, programCache, vertexShader, pixelShader, constants,
+                                     UsesManualBindings(), waitForLink);
+  sharedPrograms[key] = {program, 1};
+  return program;
+}
+
+void GLDevice::ReleaseProgram(std::uint64_t key)
+{
+  auto shared = sharedPrograms.find(key);
+  if (shared == sharedPrograms.end() || --shared->second.References > 0)
+    return;
+
+  delete shared->second.Program;
+  sharedPrograms.erase(shared);
+}
+
+void GLDevice::DestroyPipeline(ID id)
+{
+  GLPipeline* pipeline = pipelines.Get(id);
+  if (--pipeline->References > 0)
+    return;
+
+  FlushCommands();
+
+  auto pending = pendingPipelines.find(id);
+  if (pending != pendingPipelines.end())
+  {
+    pending->second.CPUWork.wait();
+    pendingPipelines.erase(pending);
+  }
+
+  if (pipeline->Program)
+    ReleaseProgram(pipeline->ProgramKey);
+  ForgetPipelineState(id, pipeline);
+  pipelines.Destroy(id);
+}
+
+bool GLDevice::AdvancePendingPipeline(ID id, PendingPipeline& pending, bool wait)
+{
+  // Step 1) Wait for the CPU side of the build on the workers
+  if (!wait && pending.CPUWork.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    return false;
+  pending.CPUWork.wait();
+
+  // Step 2) Hand the shaders to the driver. Compute programs are built in one go.
+  GLPipeline* pipeline = pending.Compute ? nullptr : pipelines.Get(id);
+  bool needsProgram = pending.Compute || !pipeline->Program;
+  if (needsProgram && !wait && !parallelShaderCompile)
+  {
+    if (blockingBuilds >= maxBlockingBuildsPerFrame)
+      return false;
+    blockingBuilds++;
+  }
+
+  if (pending.Compute)
+  {
+    computePrograms.Add(id, new GLComputeProgram(compiler, programCache,
+                                                 pending.ComputeDesc.ComputeKernels,
+                                                 pending.ComputeDesc.Constants));
+    return true;
+  }
+
+  if (!pipeline->Program)
+    pipeline->Program =
+        AcquireProgram(pending.RenderDesc.VertexShader, pending.RenderDesc.PixelShader,
+                       pending.RenderDesc.Constants, false, pipeline->ProgramKey);
+
+  // Step 3) Without the extension there is no way to ask without blocking, so we just finish.
+  if (!wait && parallelShaderCompile && pipeline->Program->IsLinkPending())
+  {
+    GLint complete = GL_FALSE;
+    glGetProgramiv(pipeline->Program->GetProgram(), GL_COMPLETION_STATUS_KHR, &complete);
+    if (!complete)
+      return false;
+  }
+
+  pipeline->Program->FinishLink();
+  return true;
+}
+
+void GLDevice::UpdatePendingPipelines()
+{
+  blockingBuilds = 0;
+  for (auto it = pendingPipelines.begin(); it != pendingPipelines.end();)
+  {
+    if (AdvancePendingPipeline(it->first, it->second, false))
+      it = pendingPipelines.erase(it);
+    else
+      it++;
+  }
 }
 
 ID GLDevice::CreateBuffer(const BufferDesc& desc)
 {
   ID id = currentID++;
-  GLBuffer* buffer = new GLBuffer(desc);
+  bool persistent = persistentBuffers && desc.Usage == BufferUsage::Dynamic;
+  GLBuffer* buffer = new GLBuffer(desc, persistent);
   buffers.Add(id, buffer);
+  stateCache.NoteBufferBound(buffer->GetType());
   return id;
 }
 
 void GLDevice::MapBufferData(ID id, void** data, std::size_t size)
 {
+  FlushCommands();
   GLBuffer* buffer = buffers.Get(id);
-  buffer->Bind();
-  (*data) = glMapBuffer(buffer->GetType(), GL_READ_ONLY);
+  (*data) = buffer->Map();
+  stateCache.NoteBufferBound(buffer->GetType());
 }
 
 void GLDevice::FreeBufferData(ID id, void** data)
 {
+  FlushCommands();
   GLBuffer* buffer = buffers.Get(id);
-  buffer->Bind();
-  glUnmapBuffer(buffer->GetType());
+  buffer->Unmap();
+  stateCache.NoteBufferBound(buffer->GetType());
   (*data) = nullptr;
 }
 
+void GLDevice::ResizeBuffer(ID id, std::size_t size)
+{
+  FlushCommands();
+  GLBuffer* buffer = buffers.Get(id);
+  GLuint oldName = buffer->GetID();
+  buffer->Resize(size);
+  stateCache.NoteBufferBound(buffer->GetType());
+
+  // persistent buffers are recreated, so nothing may keep using the old name
+  if (buffer->GetID() != oldName)
+  {
+    stateCache.ForgetBuffer(oldName);
+    vaoCache.Forget(id, stateCache);
+  }
+}
+
+void GLDevice::BindBuffer(ID id, std::size_t block, std::size_t offset, std::size_t size)
+{
+  commandList.BindBuffer(id, block, offset, size);
+  if (IsRecording())
+    return;
+
+  GLBuffer* buffer = buffers.Get(id);
+  stateCache.BindBufferRange(buffer->GetType(), block, buffer->GetID(),
+                             buffer->GetRegionOffset() + offset,
+                             size == 0 ? buffer->GetSize() : size);
+  appliedBindings = noBindings;
+}
+
+void GLDevice::DestroyBuffer(ID id)
+{
+  FlushCommands();
+  commandList.ForgetBuffer(id);
+  vaoCache.Forget(id, stateCache);
+  stateCache.ForgetBuffer(buffers.Get(id)->GetID());
+  buffers.Destroy(id);
+}
+
 ID GLDevice::CreateTexture2D(const Texture2DDesc& desc)
 {
   ID id = currentID++;
@@ -80,22 +426,71 @@ ID GLDevice::CreateTexture2D(const Texture2DDesc& desc)
   }
 
   textures.Add(id, texture);
+  stateCache.NoteTextureBound();
   return id;
 }
 
+void GLDevice::ResizeTexture2D(ID id, float width, float height)
+{
+  // the texture is recreated, so its old name is freed
+  FlushCommands();
+  GLTexture2D* texture = textures.Get(id);
+  stateCache.ForgetTexture(texture->GetGLID());
+  texture->Resize(width, height);
+  stateCache.NoteTextureBound();
+}
+
+void GLDevice::BindTexture2D(ID id, std::size_t binding)
+{
+  commandList.BindTexture(id, binding, false);
+  if (IsRecording())
+    return;
+
+  stateCache.BindTexture(binding, GL_TEXTURE_2D, textures.Get(id)->GetGLID());
+  appliedBindings = noBindings;
+}
+
+void GLDevice::DestroyTexture2D(ID id)
+{
+  FlushCommands();
+  commandList.ForgetTexture(id);
+  stateCache.ForgetTexture(textures.Get(id)->GetGLID());
+  textures.Destroy(id);
+}
+
 ID GLDevice::CreateCubemap(const CubemapDesc& desc)
 {
   ID id = currentID++;
   GLCubemap* cubemap = new GLCubemap(desc);
   cubemaps.Add(id, cubemap);
+  stateCache.NoteTextureBound();
   return id;
 }
 
+void GLDevice::BindCubemap(ID id, std::size_t binding)
+{
+  commandList.BindTexture(id, binding, true);
+  if (IsRecording())
+    return;
+
+  stateCache.BindTexture(binding, GL_TEXTURE_CUBE_MAP, cubemaps.Get(id)->GetGLID());
+  appliedBindings = noBindings;
+}
+
+void GLDevice::DestroyCubemap(ID id)
+{
+  FlushCommands();
+  commandList.ForgetTexture(id);
+  stateCache.ForgetTexture(cubemaps.Get(id)->GetGLID());
+  cubemaps.Destroy(id);
+}
+
 ID GLDevice::CreateFramebuffer(const FramebufferDesc& desc)
 {
   ID id = currentID++;
   GLFramebuffer* fb = new GLFramebuffer(desc);
   framebuffers.Add(id, fb);
+  stateCache.NoteTextureBound();
 
   // After we create the framebuffers, we assign the textures ID's and cache them.
   ID colorID = currentID++;
@@ -112,15 +507,17 @@ ID GLDevice::CreateFramebuffer(const FramebufferDesc& desc)
 void GLDevice::ResizeFramebuffer(ID id, float width, float height)
 {
   // Since we maintain a reference to our own images, we have to delete them from the cache.
+  FlushCommands();
   GLFramebuffer* fb = framebuffers.Get(id);
   ID colorID = fb->GetColorID();
   ID depthID = fb->GetDepthID();
 
   // Delete the images so we can readd the new ones.
-  textures.Destroy(colorID);
-  textures.Destroy(depthID);
+  DestroyTexture2D(colorID);
+  DestroyTexture2D(depthID);
 
   fb->Resize(width, height);
+  stateCache.NoteTextureBound();
   textures.Add(colorID, fb->GetColorAttachment());
   textures.Add(depthID, fb->GetDepthAttachment());
 }
@@ -128,9 +525,10 @@ void GLDevice::ResizeFramebuffer(ID id, float width, float height)
 void GLDevice::DestroyFramebuffer(ID id)
 {
   // We must first delete the textures assigned to this framebuffer.
+  FlushCommands();
   GLFramebuffer* fb = framebuffers.Get(id);
-  textures.Destroy(fb->GetColorID());
-  textures.Destroy(fb->GetDepthID());
+  DestroyTexture2D(fb->GetColorID());
+  DestroyTexture2D(fb->GetDepthID());
   framebuffers.Destroy(id);
 }
 
@@ -149,7 +547,155 @@ void GLDevice::BeginRenderPass(ID pass)
   SDL_assert(!computePass);
 
   activePass = pass;
-  RenderPassDesc* rp = renderpasses.Get(activePass);
+  if (!commandList.CanBeginPass())
+    ExecuteCommands();
+  commandList.BeginPass(pass, renderpasses.Get(pass)->PreserveOrder);
+}
+
+void GLDevice::EndRenderPass()
+{
+  SDL_assert(activePass);
+
+  commandList.EndPass(activePass);
+  activePass = 0;
+}
+
+void GLDevice::SetViewport(float x, float y, float w, float h)
+{
+  commandList.SetViewport(glm::vec4(x, y, w, h));
+  if (IsRecording())
+    return;
+
+  stateCache.SetViewport(glm::ivec4(x, y, w, h));
+  appliedBindings = noBindings;
+}
+
+void GLDevice::SetScissorRect(float x, float y, float w, float h)
+{
+  SDL_assert(activePass);
+  commandList.SetScissor(glm::vec4(x, y, w, h));
+}
+
+void GLDevice::Submit(const DrawCommand& command)
+{
+  SDL_assert(activePass);
+
+  // pipelines that are still building are skipped unless the command asks us to wait
+  if (!pendingPipelines.empty())
+  {
+    auto pending = pendingPipelines.find(command.RenderPipeline);
+    if (pending != pendingPipelines.end())
+    {
+      if (!command.WaitForPipeline)
+        return;
+
+      AdvancePendingPipeline(pending->first, pending->second, true);
+      pendingPipelines.erase(pending);
+    }
+  }
+
+  // blending depends on what was drawn before, so those draws keep their order
+  commandList.Draw(command, pipelines.Get(command.RenderPipeline)->EnableBlend);
+}
+
+void GLDevice::PushConstants(const void* data, std::size_t size)
+{
+  SDL_assert(size <= MaxPushConstantSize);
+
+  commandList.SetPushConstants(data, size);
+  if (IsRecording())
+    return;
+
+  UploadPushConstants(data, size);
+  appliedPushConstants = commandList.GetPushConstantVersion();
+}
+
+void GLDevice::UploadPushConstants(const void* data, std::size_t size)
+{
+  // Every push gets its own range, so draws that were already issued keep reading their data. Once
+  // the ring is full it is orphaned, and the driver hands us fresh memory instead of stalling.
+  std::size_t offset = (pushConstantOffset + uniformAlignment - 1) / uniformAlignment *
+                       uniformAlignment;
+  glBindBuffer(GL_UNIFORM_BUFFER, pushConstantBuffer);
+  if (offset + size > pushConstantRingSize)
+  {
+    glBufferData(GL_UNIFORM_BUFFER, pushConstantRingSize, nullptr, GL_STREAM_DRAW);
+    offset = 0;
+  }
+
+  glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+  stateCache.BindBufferRange(GL_UNIFORM_BUFFER, PushConstantBinding, pushConstantBuffer, offset,
+                             size);
+  pushConstantOffset = offset + size;
+}
+
+void GLDevice::ExecuteCommands()
+{
+  commandList.Sort();
+  for (std::size_t i = 0; i < commandList.GetNumCommands(); i++)
+  {
+    const GLCommandList::Command& command = commandList.GetCommand(i);
+    switch (command.Type)
+    {
+      case GLCommandList::CommandType::BeginPass: ExecuteBeginRenderPass(command.Pass); break;
+      case GLCommandList::CommandType::EndPass: ExecuteEndRenderPass(command.Pass); break;
+      case GLCommandList::CommandType::Draw:
+        ApplyBindings(command.Bindings);
+        ExecuteDraw(command);
+        break;
+    }
+  }
+
+  // Leave the bindings made after the last draw applied too, like immediate execution would have.
+  // Compute passes and anything outside the command buffer rely on it.
+  ApplyBindings(commandList.CaptureBindings());
+  commandList.Clear();
+  appliedBindings = noBindings;
+}
+
+void GLDevice::ApplyBindings(std::size_t offset)
+{
+  if (offset == appliedBindings)
+    return;
+  appliedBindings = offset;
+
+  // the state cache drops whatever the previous bindings already set
+  const GLCommandList::Bindings& bindings = commandList.GetBindings(offset);
+  for (const GLCommandList::TextureBinding& texture : commandList.GetTextures(bindings))
+  {
+    if (texture.Cubemap)
+      stateCache.BindTexture(texture.Unit, GL_TEXTURE_CUBE_MAP,
+                             cubemaps.Get(texture.Texture)->GetGLID());
+    else
+      stateCache.BindTexture(texture.Unit, GL_TEXTURE_2D, textures.Get(texture.Texture)->GetGLID());
+  }
+
+  for (const GLCommandList::BufferBinding& binding : commandList.GetBuffers(bindings))
+  {
+    GLBuffer* buffer = buffers.Get(binding.Buffer);
+    stateCache.BindBufferRange(buffer->GetType(), binding.Block, buffer->GetID(),
+                               buffer->GetRegionOffset() + binding.Offset,
+                               binding.Size == 0 ? buffer->GetSize() : binding.Size);
+  }
+
+  if (bindings.PushConstantSize && bindings.PushConstantVersion != appliedPushConstants)
+  {
+    UploadPushConstants(commandList.GetPushConstants(bindings), bindings.PushConstantSize);
+    appliedPushConstants = bindings.PushConstantVersion;
+  }
+
+  if (bindings.HasViewport)
+    stateCache.SetViewport(glm::ivec4(bindings.Viewport));
+
+  if (bindings.HasScissor)
+    ApplyScissorRect(bindings.Scissor);
+  else
+    stateCache.SetEnabled(GL_SCISSOR_TEST, false);
+}
+
+void GLDevice::ExecuteBeginRenderPass(ID pass)
+{
+  RenderPassDesc* rp = renderpasses.Get(pass);
   ID fbID = rp->Framebuffer;
 
   if (fbID != 0) // don't bind a the default framebuffer.
@@ -160,94 +706,78 @@ void GLDevice::BeginRenderPass(ID pass)
   {
     glm::vec4& col = rp->ClearColor;
     glClearColor(col.r, col.g, col.b, col.a);
-    glDepthMask(GL_TRUE);
+    stateCache.SetDepthMask(true);
     glClear(GL_COLOR_BUFFER_BIT |
             GL_DEPTH_BUFFER_BIT); // TODO: These may want to be controlled separately
   }
 }
 
-void GLDevice::EndRenderPass()
+void GLDevice::ExecuteEndRenderPass(ID pass)
 {
-  SDL_assert(activePass);
-
-  ID fbID = renderpasses.Get(activePass)->Framebuffer;
+  ID fbID = renderpasses.Get(pass)->Framebuffer;
   if (fbID != 0)
     framebuffers.Get(fbID)->Unbind();
-  activePass = 0;
 
   // render pass StoreOps are pointless in GL.
-  glDisable(GL_SCISSOR_TEST);
+  stateCache.SetEnabled(GL_SCISSOR_TEST, false);
 }
 
-void GLDevice::SetScissorRect(float x, float y, float w, float h)
+void GLDevice::ApplyScissorRect(const glm::vec4& rect)
 {
-  SDL_assert(activePass);
-
-  if (width <= 0 || height <= 0)
+  // an empty rect turns scissoring off
+  if (rect.z <= 0 || rect.w <= 0)
   {
-    glScissor(0, 0, width, height);
-    glDisable(GL_SCISSOR_TEST);
+    stateCache.SetEnabled(GL_SCISSOR_TEST, false);
     return;
   }
 
-  glEnable(GL_SCISSOR_TEST);
-  glScissor(x, this->height - (y + h), w, h);
+  stateCache.SetEnabled(GL_SCISSOR_TEST, true);
+  stateCache.SetScissor(glm::ivec4(rect.x, height - (rect.y + rect.w), rect.z, rect.w));
 }
 
-void GLDevice::Submit(const DrawCommand& command)
+void GLDevice::ExecuteDraw(const GLCommandList::Command& command)
 {
-  SDL_assert(activePass);
-
-  // bind the shader and upload uniforms
-  GLPipeline* pipeline = pipelines.Get(command.RenderPipeline);
-  GLProgram* program = pipeline->Program;
-  program->Use();
-
-  // setup our GL state
-  glDepthMask(pipeline->DepthWrite ? GL_TRUE : GL_FALSE);
-  glDepthFunc(pipeline->DepthFunc);
-  if (pipeline->DepthTest)
-    glEnable(GL_DEPTH_TEST);
-  else
-    glDisable(GL_DEPTH_TEST);
-
-  if (pipeline->EnableBlend)
-    glEnable(GL_BLEND);
-  else
-    glDisable(GL_BLEND);
-  glBlendFunc(pipeline->BlendSource, pipeline->BlendDst);
+  GLPipeline* pipeline = pipelines.Get(command.Pipeline);
+  stateCache.UseProgram(pipeline->Program->GetProgram());
 
-  glPolygonMode(GL_FRONT_AND_BACK, pipeline->FillMode);
+  // setup our GL state, the cache drops whatever the last draw already set
+  stateCache.SetDepthMask(pipeline->DepthWrite);
+  stateCache.SetDepthFunc(pipeline->DepthFunc);
+  stateCache.SetEnabled(GL_DEPTH_TEST, pipeline->DepthTest);
+  stateCache.SetEnabled(GL_BLEND, pipeline->EnableBlend);
+  stateCache.SetBlendFunc(pipeline->BlendSource, pipeline->BlendDst);
+  stateCache.SetPolygonMode(pipeline->FillMode);
 
   // choose the primitive type and index type
-  GLenum primitive = PrimitiveTypeToGLenum(command.Type);
+  GLenum primitive = PrimitiveTypeToGLenum(command.Primitive);
 
   // generate the vertex array using the vertex array cache
-  GLVertexArray* vao = vaoCache.Fetch(this, command.RenderPipeline, command.VertexBuffers);
-  vao->Bind();
+  std::span<const ID> vertexBuffers = commandList.GetVertexBuffers(command);
+  GLVertexArray* vao = vaoCache.Fetch(this, command.Pipeline, vertexBuffers);
+  stateCache.BindVertexArray(vao->GetID());
 
   // draw
   if (command.IndexBuffer)
   {
-    GLenum indexType = IndexTypeToGLenum(command.IndexType);
+    GLenum indexType = IndexTypeToGLenum(command.Indices);
     GLBuffer* indexBuffer = buffers.Get(command.IndexBuffer);
-    indexBuffer->Bind();
+    stateCache.BindIndexBuffer(indexBuffer->GetID());
+    void* indexOffset =
+        reinterpret_cast<void*>(indexBuffer->GetRegionOffset() + command.IndexOffset);
 
     // Unfortunately, vertex offsets aren't sophisticated in OpenGL. We only set a constant to add
     // to all indices rather than an offset in bytes for each vertex buffer. For most purposes this
     // is sufficient. This means we'll only acknowledge the first vertex offset, and use it for all.
-    if (!command.VertexOffsets.empty())
+    if (command.HasVertexOffset)
     {
-      std::size_t offsetBytes = static_cast<GLint>(command.VertexOffsets[0]);
-      std::size_t bytesPerVertex = buffers.Get(command.VertexBuffers[0])->GetLayout().Stride;
+      std::size_t offsetBytes = command.VertexOffset;
+      std::size_t bytesPerVertex = buffers.Get(vertexBuffers[0])->GetLayout().Stride;
 
-      glDrawElementsBaseVertex(primitive, command.NumVertices, indexType,
-                               reinterpret_cast<void*>(command.IndexOffset),
+      glDrawElementsBaseVertex(primitive, command.NumVertices, indexType, indexOffset,
                                static_cast<GLint>(offsetBytes / bytesPerVertex));
     }
     else
-      glDrawElements(primitive, command.NumVertices, indexType,
-                     reinterpret_cast<void*>(command.IndexOffset));
+      glDrawElements(primitive, command.NumVertices, indexType, indexOffset);
   }
   else
   {
@@ -259,6 +789,132 @@ void GLDevice::BeginCommandBuffer()
 {
   SDL_assert(!commandBufferActive);
   commandBufferActive = true;
+
+  // finish off any async pipelines whose builds completed since last frame
+  if (!pendingPipelines.empty())
+    UpdatePendingPipelines();
+
+  if (!shaderReplacements.empty())
+    ApplyShaderReplacements();
+}
+
+void GLDevice::ReplaceShader(std::uint64_t oldCodeHash, std::uint64_t newCodeHash,
+                             const ShaderSPIRV& shader)
+{
+  shaderReplacements.push_back({oldCodeHash, newCodeHash, shader});
+}
+
+void GLDevice::ApplyShaderReplacements()
+{
+  // The last replacement of each hash. Saves between frames can chain (A to B to C), which resolve
+  // follows, only ever forward so edits that go back to earlier code can't loop.
+  std::unordered_map<std::uint64_t, std::size_t> latest;
+  for (std::size_t i = 0; i < shaderReplacements.size(); i++)
+    latest[shaderReplacements[i].OldCodeHash] = i;
+
+  auto resolve = [this, &latest](std::uint64_t codeHash) -> const ShaderReplacement*
+  {
+    auto found = latest.find(codeHash);
+    if (found == latest.end())
+      return nullptr;
+
+    std::size_t index = found->second;
+    for (auto next = latest.find(shaderReplacements[index].NewCodeHash);
+         next != latest.end() && next->second > index;
+         next = latest.find(shaderReplacements[index].NewCodeHash))
+      index = next->second;
+    return &shaderReplacements[index];
+  };
+
+  // Programs that failed to link are held until every pipeline has tried them, so pipelines
+  // sharing a program don't each rebuild the broken one.
+  std::vector<std::uint64_t> failedPrograms;
+
+  for (auto& pair : pipelines)
+  {
+    GLPipeline* pipeline = pair.second;
+    const ShaderReplacement* vertexReplacement = resolve(pipeline->VertexHash);
+    const ShaderReplacement* pixelReplacement = resolve(pipeline->PixelHash);
+    if (!vertexReplacement && !pixelReplacement)
+      continue;
+
+    const ShaderSPIRV& vertexShader =
+        vertexReplacement ? vertexReplacement->Shader : pipeline->VertexShader;
+    const ShaderSPIRV& pixelShader =
+        pixelReplacement ? pixelReplacement->Shader : pipeline->PixelShader;
+    std::uint64_t vertexHash =
+        vertexReplacement ? vertexReplacement->NewCodeHash : pipeline->VertexHash;
+    std::uint64_t pixelHash =
+        pixelReplacement ? pixelReplacement->NewCodeHash : pipeline->PixelHash;
+
+    // Pipelines that are still building pick the new shaders up when they are built. One that is
+    // already linking starts over.
+    auto pending = pendingPipelines.find(pair.first);
+    if (pending != pendingPipelines.end())
+    {
+      pending->second.RenderDesc.VertexShader = vertexShader;
+      pending->second.RenderDesc.PixelShader = pixelShader;
+      if (pipeline->Program)
+      {
+        ReleaseProgram(pipeline->ProgramKey);
+        pipeline->Program = nullptr;
+      }
+    }
+    else
+    {
+      // Both stages go into one program, and the old one is only let go once it has linked.
+      // Pipelines sharing a program find the new one already built.
+      std::uint64_t key;
+      GLProgram* program =
+          AcquireProgram(vertexShader, pixelShader, pipeline->Constants, true, key);
+      if (!program->IsLinked())
+      {
+        std::cout << "Keeping the previous program of " << pipeline->VertexShader.Name << ", "
+                  << pipeline->PixelShader.Name << std::endl;
+        failedPrograms.push_back(key);
+        continue;
+      }
+
+      ReleaseProgram(pipeline->ProgramKey);
+      pipeline->Program = program;
+      pipeline->ProgramKey = key;
+    }
+
+    pipeline->VertexShader = vertexShader;
+    pipeline->PixelShader = pixelShader;
+    pipeline->VertexHash = vertexHash;
+    pipeline->PixelHash = pixelHash;
+
+    ForgetPipelineState(pair.first, pipeline);
+    pipeline->StateKey = HashPipelineState(*pipeline);
+    pipelineStates.try_emplace(pipeline->StateKey, pair.first);
+  }
+
+  for (std::uint64_t key : failedPrograms)
+    ReleaseProgram(key);
+
+  // Pending compute pipelines don't keep their kernels' hashes, so only they are hashed here
+  for (auto& pair : pendingPipelines)
+  {
+    for (ShaderSPIRV& kernel : pair.second.ComputeDesc.ComputeKernels)
+    {
+      if (const ShaderReplacement* replacement = resolve(kernel.GetCodeHash()))
+        kernel = replacement->Shader;
+    }
+  }
+
+  // Kernels that fail to build keep running their previous code
+  for (auto& pair : computePrograms)
+  {
+    for (auto& replaced : latest)
+    {
+      const ShaderReplacement* replacement = resolve(replaced.first);
+      pair.second->ReplaceKernel(compiler, programCache, replaced.first, replacement->NewCodeHash,
+                                 replacement->Shader);
+    }
+  }
+
+  shaderReplacements.clear();
 }
 
 void GLDevice::SubmitCommandBuffer(bool await)
@@ -266,11 +922,14 @@ void GLDevice::SubmitCommandBuffer(bool await)
   SDL_assert(!activePass);
   SDL_assert(!computePass);
   SDL_assert(commandBufferActive);
+
+  ExecuteCommands();
   commandBufferActive = false;
 
   if (schedulePresent)
   {
-    SDL_GL_SwapWindow(window);
+    if (window) // headless contexts have nothing to present to
+      SDL_GL_SwapWindow(window);
     schedulePresent = false;
   }
 
@@ -289,6 +948,7 @@ void GLDevice::SchedulePresentation()
 void GLDevice::BufferBarrier()
 {
   SDL_assert(versionMajor >= 4 && versionMinor >= 3);
+  FlushCommands();
 
   // Until we have a more verbose API, or an intelligent dependency
   // system, we must block all accesses to buffers in the GPU until
@@ -302,6 +962,7 @@ void GLDevice::ImageBarrier()
 {
   // Memory barriers don't exist in old GL. only use
   SDL_assert(versionMajor >= 4 && versionMinor >= 2);
+  FlushCommands();
 
   glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
                   GL_PIXEL_BUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT |
@@ -314,17 +975,53 @@ ID GLDevice::CreateComputePipeline(const ComputePipelineDesc& desc)
   SDL_assert(versionMajor >= 4 && versionMinor >= 3);
 
   ID id = currentID++;
-  GLComputeProgram* program = new GLComputeProgram(desc.ComputeKernels);
+  GLComputeProgram* program =
+      new GLComputeProgram(compiler, programCache, desc.ComputeKernels, desc.Constants);
   computePrograms.Add(id, program);
   return id;
 }
 
+ID GLDevice::CreateComputePipelineAsync(const ComputePipelineDesc& desc)
+{
+  SDL_assert(versionMajor >= 4 && versionMinor >= 3);
+
+  ID id = currentID++;
+  PendingPipeline& pending = pendingPipelines[id];
+  pending.Compute = true;
+  pending.ComputeDesc = desc;
+  pending.CPUWork = pipelineWorkers.Submit(
+      [this, kernels = desc.ComputeKernels, constants = desc.Constants]()
+      {
+        for (const ShaderSPIRV& kernel : kernels)
+          if (!programCache.Contains(programCache.ComputeKey({&kernel}, 450, constants)))
+            compiler.Decompile(kernel, 450, constants);
+      });
+
+  return id;
+}
+
+void GLDevice::DestroyComputePipeline(ID id)
+{
+  auto pending = pendingPipelines.find(id);
+  if (pending != pendingPipelines.end())
+  {
+    pending->second.CPUWork.wait();
+    pendingPipelines.erase(pending);
+    return;
+  }
+
+  computePrograms.Destroy(id);
+}
+
 void GLDevice::BeginComputePass()
 {
   SDL_assert(commandBufferActive);
   SDL_assert(!activePass);
   SDL_assert(!computePass);
 
+  // compute runs immediately, so whatever was recorded before it has to go first
+  ExecuteCommands();
+
   // If we assert that all of the conditions are true before beginning,
   // we can simply verify that a valid compute pass is active for each
   // command, instead of checking for a command buffer, etc.
@@ -359,8 +1056,16 @@ void GLDevice::DispatchCompute(ID pipeline, const std::string& kernel, const glm
 {
   SDL_assert(computePass);
 
+  // dispatches usually produce data something else depends on, so they always wait
+  auto pending = pendingPipelines.find(pipeline);
+  if (pending != pendingPipelines.end())
+  {
+    AdvancePendingPipeline(pending->first, pending->second, true);
+    pendingPipelines.erase(pending);
+  }
+
   GLComputeProgram* program = computePrograms.Get(pipeline);
-  program->Use(kernel);
+  stateCache.UseProgram(program->GetProgram(kernel));
   glDispatchCompute(threads.x, threads.y, threads.z);
 }
 
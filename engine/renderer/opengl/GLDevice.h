@@ -1,14 +1,22 @@
 #pragma once
 
 #include <SDL.h>
+#include <future>
+#include <unordered_map>
 
 #include "renderer/RenderDevice.h"
 #include "renderer/primitive/ObjectCache.h"
 
+#include "core/ThreadPool.h"
+
 #include "GLBuffer.h"
+#include "GLCommandList.h"
+#include "GLCompiler.h"
 #include "GLFramebuffer.h"
 #include "GLPipeline.h"
 #include "GLProgram.h"
+#include "GLProgramCache.h"
+#include "GLStateCache.h"
 #include "GLTexture.h"
 #include "GLVertexArray.h"
 
@@ -18,41 +26,55 @@ namespace Vision
 class GLDevice : public RenderDevice
 {
 public:
-  GLDevice(SDL_Window* wind, float w, float h);
+  // The loader resolves GL functions for the current context. The window is null for headless
+  // contexts, which don't present.
+  GLDevice(SDL_Window* wind, float w, float h, GLADloadproc loader);
+  ~GLDevice();
 
   ID CreateRenderPipeline(const RenderPipelineDesc& desc);
+  ID CreateRenderPipelineAsync(const RenderPipelineDesc& desc);
+  bool IsPipelineReady(ID pipeline) { return !pendingPipelines.contains(pipeline); }
   GLPipeline* GetPipeline(ID pipeline) { return pipelines.Get(pipeline); }
-  void DestroyPipeline(ID pipeline) { pipelines.Destroy(pipeline); }
+  void DestroyPipeline(ID pipeline);
+  void ReplaceShader(std::uint64_t oldCodeHash, std::uint64_t newCodeHash,
+                     const ShaderSPIRV& shader);
 
   ID CreateBuffer(const BufferDesc& desc);
   void SetBufferData(ID buffer, void* data, std::size_t size, std::size_t offset)
   {
-    buffers.Get(buffer)->SetData(data, size, offset);
+    FlushCommands();
+    GLBuffer* glBuffer = buffers.Get(buffer);
+    glBuffer->SetData(data, size, offset);
+    stateCache.NoteBufferBound(glBuffer->GetType());
   }
   void MapBufferData(ID buffer, void** data, std::size_t size);
   void FreeBufferData(ID id, void** data);
-  void ResizeBuffer(ID buffer, std::size_t size) { buffers.Get(buffer)->Resize(size); }
-  void BindBuffer(ID buffer, std::size_t block = 0, std::size_t offset = 0, std::size_t size = 0)
-  {
-    buffers.Get(buffer)->Attach(block, offset, size);
-  }
+  void ResizeBuffer(ID buffer, std::size_t size);
+  void BindBuffer(ID buffer, std::size_t block = 0, std::size_t offset = 0, std::size_t size = 0);
   GLBuffer* GetBuffer(ID buffer) { return buffers.Get(buffer); }
-  void DestroyBuffer(ID id) { buffers.Destroy(id); }
+  void DestroyBuffer(ID id);
 
   ID CreateTexture2D(const Texture2DDesc& desc);
-  void ResizeTexture2D(ID id, float width, float height)
+  void ResizeTexture2D(ID id, float width, float height);
+  void SetTexture2DData(ID id, uint8_t* data)
   {
-    textures.Get(id)->Resize(width, height);
+    FlushCommands();
+    textures.Get(id)->SetData(data);
+    stateCache.NoteTextureBound();
   }
-  void SetTexture2DData(ID id, uint8_t* data) { textures.Get(id)->SetData(data); }
-  void SetTexture2DDataRaw(ID id, void* data) { textures.Get(id)->SetDataRaw(data); }
-  void BindTexture2D(ID id, std::size_t binding = 0) { textures.Get(id)->Bind(binding); }
+  void SetTexture2DDataRaw(ID id, void* data)
+  {
+    FlushCommands();
+    textures.Get(id)->SetDataRaw(data);
+    stateCache.NoteTextureBound();
+  }
+  void BindTexture2D(ID id, std::size_t binding = 0);
   GLTexture2D* GetTexture2D(ID id) { return textures.Get(id); }
-  void DestroyTexture2D(ID id) { textures.Destroy(id); }
+  void DestroyTexture2D(ID id);
 
   ID CreateCubemap(const CubemapDesc& desc);
-  void BindCubemap(ID id, std::size_t binding = 0) { cubemaps.Get(id)->Bind(binding); }
-  void DestroyCubemap(ID id) { cubemaps.Destroy(id); }
+  void BindCubemap(ID id, std::size_t binding = 0);
+  void DestroyCubemap(ID id);
 
   ID CreateFramebuffer(const FramebufferDesc& desc);
   ID GetFramebufferColorTex(ID id) { return framebuffers.Get(id)->GetColorID(); }
@@ -65,14 +87,17 @@ public:
   void BeginRenderPass(ID pass);
   void EndRenderPass();
   RenderPassDesc* GetRenderPass(ID id) { return renderpasses.Get(id); }
-  void DestroyRenderPass(ID id) { renderpasses.Destroy(id); }
-
-  virtual void SetViewport(float x, float y, float width, float height)
+  void DestroyRenderPass(ID id)
   {
-    glViewport(x, y, width, height);
+    FlushCommands();
+    renderpasses.Destroy(id);
   }
+
+  virtual void SetViewport(float x, float y, float width, float height);
   virtual void SetScissorRect(float x, float y, float width, float height);
   void Submit(const DrawCommand& command);
+  using RenderDevice::Submit;
+  void PushConstants(const void* data, std::size_t size);
 
   // Only should be used for RAW dependencies, since GL automatically handles others.
   void BufferBarrier();
@@ -84,7 +109,8 @@ public:
 
   // compute pipeline
   ID CreateComputePipeline(const ComputePipelineDesc& desc);
-  void DestroyComputePipeline(ID id) { computePrograms.Destroy(id); }
+  ID CreateComputePipelineAsync(const ComputePipelineDesc& desc);
+  void DestroyComputePipeline(ID id);
 
   void BeginComputePass();
   void EndComputePass();
@@ -96,13 +122,55 @@ public:
 
   RenderAPI GetRenderAPI() const { return RenderAPI::OpenGL; }
 
+  const GLProgramBinaryCache& GetProgramCache() const { return programCache; }
+  const GLStateCache& GetStateCache() const { return stateCache; }
+  void ResetStateCounters() { stateCache.ResetCounters(); }
+
+private:
+  struct PendingPipeline
+  {
+    std::future<void> CPUWork;
+    bool Compute = false;
+    RenderPipelineDesc RenderDesc;
+    ComputePipelineDesc ComputeDesc;
+  };
+
+  GLPipeline* CreatePipelineState(const RenderPipelineDesc& desc);
+  ID ShareExistingPipeline(GLPipeline* pipeline);
+  void ForgetPipelineState(ID id, const GLPipeline* pipeline);
+  GLProgram* AcquireProgram(const ShaderSPIRV& vertexShader, const ShaderSPIRV& pixelShader,
+                            const std::vector<SpecializationConstant>& constants, bool waitForLink,
+                            std::uint64_t& key);
+  void ReleaseProgram(std::uint64_t key);
+  bool AdvancePendingPipeline(ID id, PendingPipeline& pending, bool wait);
+  void UpdatePendingPipelines();
+  void ApplyShaderReplacements();
+
+  // Draws are recorded while a command buffer is active (outside of compute passes) and replayed,
+  // sorted, when it is submitted or when something they depend on is about to change.
+  bool IsRecording() const { return commandBufferActive && !computePass; }
+  void FlushCommands()
+  {
+    if (!commandList.IsEmpty())
+      ExecuteCommands();
+  }
+  void ExecuteCommands();
+  void ApplyBindings(std::size_t bindings);
+  void ExecuteBeginRenderPass(ID pass);
+  void ExecuteEndRenderPass(ID pass);
+  void ExecuteDraw(const GLCommandList::Command& command);
+  void ApplyScissorRect(const glm::vec4& rect);
+  void UploadPushConstants(const void* data, std::size_t size);
+  bool UsesManualBindings() const { return versionMinor < 2 || versionMajor < 4; }
+
 private:
   friend class GLContext;
+  friend class GLHeadlessContext;
   void UpdateSize(float w, float h)
   {
     width = w;
     height = h;
-    glViewport(0, 0, width, height);
+    SetViewport(0, 0, width, height);
   }
 
 private:
@@ -121,16 +189,68 @@ private:
   ObjectCache<RenderPassDesc> renderpasses;
   ObjectCache<GLComputeProgram> computePrograms;
 
+  // Pipelines are deduplicated by a hash of their state, and programs by the program cache key of
+  // their shaders. Both are reference counted, so every Create needs a matching Destroy.
+  struct SharedProgram
+  {
+    GLProgram* Program;
+    std::size_t References;
+  };
+  std::unordered_map<std::uint64_t, SharedProgram> sharedPrograms;
+  std::unordered_map<std::uint64_t, ID> pipelineStates;
+
   // vertex arrays aren't really real outside of opengl, so the engine caches them.
   // we hash to select one without having to rebuild each render.
   GLVertexArrayCache vaoCache;
 
+  // every draw and dispatch binds through this, so unchanged state is never reissued
+  GLStateCache stateCache;
+
+  // recorded draws, and the bindings last applied while replaying them
+  static constexpr std::size_t noBindings = ~std::size_t(0);
+  GLCommandList commandList;
+  std::size_t appliedBindings = noBindings;
+  std::uint64_t appliedPushConstants = 0;
+
+  // spirv-cross output is cached here, shared by every program the device builds.
+  GLCompiler compiler;
+  GLProgramBinaryCache programCache;
+
+  // async pipelines, keyed by the ID handed out for them
+  std::unordered_map<ID, PendingPipeline> pendingPipelines;
+  bool parallelShaderCompile = false;
+
+  // Without parallel compile, handing a pipeline to the driver blocks until it is linked, so only a
+  // few are finished each frame and the rest stay pending.
+  static constexpr std::size_t maxBlockingBuildsPerFrame = 2;
+  std::size_t blockingBuilds = 0;
+
+  // whether dynamic buffers are persistently mapped, see GLBuffer
+  bool persistentBuffers = false;
+
+  // hot reloaded shaders, swapped in at the next frame boundary
+  struct ShaderReplacement
+  {
+    std::uint64_t OldCodeHash;
+    std::uint64_t NewCodeHash;
+    ShaderSPIRV Shader;
+  };
+  std::vector<ShaderReplacement> shaderReplacements;
+
+  // push constants are written to successive ranges of this buffer, see PushConstants
+  GLuint pushConstantBuffer = 0;
+  std::size_t pushConstantOffset = 0;
+  GLint uniformAlignment = 256;
+
   // renderer data
   ID activePass = 0;
   bool commandBufferActive = false;
   bool computePass = false;
 
   bool schedulePresent = false;
+
+  // declared last so it's torn down before anything its jobs reference
+  ThreadPool pipelineWorkers;
 };
 
 } // namespace Vision
\ No newline at end of file
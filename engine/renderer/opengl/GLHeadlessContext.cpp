@@ -0,0 +1,136 @@
+#include "GLHeadlessContext.h"
+
+#ifdef VISION_LINUX
+
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <iostream>
+
+namespace Vision
+{
+
+GLHeadlessContext::GLHeadlessContext(float w, float h)
+    : width(w), height(h)
+{
+  // Use the surfaceless platform where it exists, as it doesn't need X11 or Wayland
+  EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+  auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+      eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  if (getPlatformDisplay)
+    eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+  if (eglDisplay == EGL_NO_DISPLAY)
+    eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+  EGLint eglMajor, eglMinor;
+  if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &eglMajor, &eglMinor) ||
+      !eglBindAPI(EGL_OPENGL_API))
+  {
+    std::cout << "Failed to initialize EGL!" << std::endl;
+    return;
+  }
+  display = eglDisplay;
+
+  const EGLint configAttributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                                     EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                     EGL_RED_SIZE, 8,
+                                     EGL_GREEN_SIZE, 8,
+                                     EGL_BLUE_SIZE, 8,
+                                     EGL_ALPHA_SIZE, 8,
+                                     EGL_DEPTH_SIZE, 24,
+                                     EGL_NONE};
+  EGLConfig eglConfig;
+  EGLint numConfigs = 0;
+  if (!eglChooseConfig(eglDisplay, configAttributes, &eglConfig, 1, &numConfigs) ||
+      numConfigs == 0)
+  {
+    std::cout << "Failed to find an EGL config for OpenGL!" << std::endl;
+    return;
+  }
+  config = eglConfig;
+
+  // Ask for the same 4.6 core context as GLContext, settling for older versions since software
+  // rasterizers don't always go that far.
+  EGLContext eglContext = EGL_NO_CONTEXT;
+  for (EGLint minor : {6, 5, 3})
+  {
+    const EGLint contextAttributes[] = {EGL_CONTEXT_MAJOR_VERSION, 4,
+                                        EGL_CONTEXT_MINOR_VERSION, minor,
+                                        EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                        EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                        EGL_NONE};
+    eglContext = eglCreateContext(eglDisplay, eglConfig, EGL_NO_CONTEXT, contextAttributes);
+    if (eglContext != EGL_NO_CONTEXT)
+      break;
+  }
+
+  if (eglContext == EGL_NO_CONTEXT)
+  {
+    std::cout << "Failed to create a headless OpenGL context!" << std::endl;
+    return;
+  }
+  context = eglContext;
+
+  if (!CreateSurface())
+    return;
+
+  device = new GLDevice(nullptr, width, height,
+                        reinterpret_cast<GLADloadproc>(eglGetProcAddress));
+
+  std::cout << "Created headless OpenGL Context: " << glGetString(GL_VERSION) << std::endl;
+}
+
+GLHeadlessContext::~GLHeadlessContext()
+{
+  delete device;
+
+  if (!display)
+    return;
+
+  eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (surface)
+    eglDestroySurface(display, surface);
+  if (context)
+    eglDestroyContext(display, context);
+  eglTerminate(display);
+}
+
+void GLHeadlessContext::Resize(float w, float h)
+{
+  width = w;
+  height = h;
+
+  // pbuffers can't be resized, so we swap in a new one of the right size
+  if (device && CreateSurface())
+    device->UpdateSize(width, height);
+}
+
+bool GLHeadlessContext::CreateSurface()
+{
+  const EGLint surfaceAttributes[] = {EGL_WIDTH, static_cast<EGLint>(width),
+                                      EGL_HEIGHT, static_cast<EGLint>(height),
+                                      EGL_NONE};
+  EGLSurface eglSurface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+  if (eglSurface == EGL_NO_SURFACE)
+  {
+    std::cout << "Failed to create a " << width << "x" << height << " pbuffer!" << std::endl;
+    return false;
+  }
+
+  if (!eglMakeCurrent(display, eglSurface, eglSurface, context))
+  {
+    std::cout << "Failed to make the headless OpenGL context current!" << std::endl;
+    eglDestroySurface(display, eglSurface);
+    return false;
+  }
+
+  if (surface)
+    eglDestroySurface(display, surface);
+  surface = eglSurface;
+  return true;
+}
+
+} // namespace Vision
+
+#endif // VISION_LINUX
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "core/Macros.h"
+
+#ifdef VISION_LINUX
+
+#include "renderer/RenderContext.h"
+
+#include "renderer/opengl/GLDevice.h"
+
+namespace Vision
+{
+
+// An OpenGL context without a window, created through EGL. It prefers Mesa's surfaceless platform,
+// so it works without a display server, and renders into an offscreen pbuffer that stands in for
+// the default framebuffer. With Mesa's software rasterizer this needs no GPU at all.
+class GLHeadlessContext : public RenderContext
+{
+public:
+  GLHeadlessContext(float width, float height);
+  ~GLHeadlessContext();
+
+  void Resize(float width, float height);
+
+  RenderDevice* GetRenderDevice() { return device; }
+  float GetDisplayScale() const { return 1.0f; }
+  PixelType GetPixelType() const { return PixelType::RGBA8; }
+
+  bool IsValid() const { return device != nullptr; }
+
+private:
+  bool CreateSurface();
+
+private:
+  // EGL handles, kept opaque so that including this doesn't pull in the platform headers
+  void* display = nullptr;
+  void* config = nullptr;
+  void* context = nullptr;
+  void* surface = nullptr;
+
+  GLDevice* device = nullptr;
+  float width, height;
+};
+
+} // namespace Vision
+
+#endif // VISION_LINUX
@@ -7,10 +7,22 @@
 namespace Vision
 {
 
+// Pipelines with identical state share one of these, and pipelines with identical shaders share
+// their program. Both are reference counted by the device.
 struct GLPipeline
 {
   GLProgram* Program;
+  std::uint64_t ProgramKey = 0;
+  std::uint64_t StateKey = 0;
+  std::size_t References = 1;
+
   std::vector<BufferLayout> Layouts;
+  std::uint64_t LayoutHash = 0; // everything but the names, which GL doesn't care about
+
+  // kept so the program can be rebuilt when one of its shaders is replaced
+  ShaderSPIRV VertexShader, PixelShader;
+  std::uint64_t VertexHash, PixelHash;
+  std::vector<SpecializationConstant> Constants;
 
   bool DepthTest;
   bool DepthWrite;
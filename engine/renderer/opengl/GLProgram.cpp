@@ -1,11 +1,14 @@
 #include "GLProgram.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <SDL.h>
 
 #include "GLTypes.h"
 #include "GLCompiler.h"
+#include "GLProgramCache.h"
 
 #include "renderer/shader/ShaderReflector.h"
 
@@ -14,52 +17,101 @@ namespace Vision
 
 // ----- GLProgram -----
 
-GLProgram::GLProgram(const ShaderSPIRV& vertexShader, const ShaderSPIRV& fragmentShader, bool manualBindings)
+GLProgram::GLProgram(GLCompiler& compiler, GLProgramBinaryCache& cache,
+                     const ShaderSPIRV& vertexShader, const ShaderSPIRV& fragmentShader,
+                     const std::vector<SpecializationConstant>& constants, bool manualBindings,
+                     bool waitForLink)
   : program(0)
 {
-  GLCompiler compiler;
-
   uint32_t version = manualBindings ? 410 : 450;
-  GLuint vs = compiler.Compile(vertexShader, version);
-  GLuint fs = compiler.Compile(fragmentShader, version);
+
+  // a cached binary skips both spirv-cross and the driver's compiler
+  std::uint64_t key = cache.ComputeKey({&vertexShader, &fragmentShader}, version, constants);
+  program = cache.Load(key);
+
+  if (program)
+  {
+    linked = true;
+    BuildUniformTable();
+
+    // use a reflector to attach what we can. uniform state isn't part of a program binary, so this
+    // happens on cache hits too.
+    if (manualBindings)
+    {
+      Reflect(vertexShader);
+      Reflect(fragmentShader);
+    }
+    return;
+  }
+
+  // Neither compile nor link status is queried until FinishLink. Drivers with
+  // KHR_parallel_shader_compile do the work on their own threads in the meantime.
+  pendingLink = std::make_unique<PendingLink>();
+  pendingLink->Cache = &cache;
+  pendingLink->Key = key;
+  pendingLink->VertexShader = vertexShader;
+  pendingLink->FragmentShader = fragmentShader;
+  pendingLink->ManualBindings = manualBindings;
+  pendingLink->VS = compiler.Compile(vertexShader, version, false, constants);
+  pendingLink->FS = compiler.Compile(fragmentShader, version, false, constants);
 
   // attach the shaders to a program and link it
   program = glCreateProgram();
-  glAttachShader(program, vs);
-  glAttachShader(program, fs);
+  glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  glAttachShader(program, pendingLink->VS);
+  glAttachShader(program, pendingLink->FS);
   glLinkProgram(program);
 
+  if (waitForLink)
+    FinishLink();
+}
+
+void GLProgram::FinishLink()
+{
+  if (!pendingLink)
+    return;
+
   int success;
   glGetProgramiv(program, GL_LINK_STATUS, &success);
   if (!success)
   {
     constexpr static std::size_t bufferSize = 512;
     char infoLog[bufferSize];
+    GLCompiler::LogCompileErrors(pendingLink->VS, pendingLink->VertexShader);
+    GLCompiler::LogCompileErrors(pendingLink->FS, pendingLink->FragmentShader);
     glGetProgramInfoLog(program, bufferSize, nullptr, infoLog);
 
-    std::cout << "Failed to link shader program with shaders: " << vertexShader.Name << ", " << fragmentShader.Name  << std::endl;
+    std::cout << "Failed to link shader program with shaders: " << pendingLink->VertexShader.Name << ", " << pendingLink->FragmentShader.Name  << std::endl;
     std::cout << infoLog << std::endl;
   }
+  else
+  {
+    linked = true;
+    pendingLink->Cache->Store(pendingLink->Key, program);
+    BuildUniformTable();
+  }
 
   // delete our shaders now that we have linked
-  glDeleteShader(vs);
-  glDeleteShader(fs);
+  glDeleteShader(pendingLink->VS);
+  glDeleteShader(pendingLink->FS);
 
   // use a reflector to attach what we can
-  if (manualBindings)
+  if (pendingLink->ManualBindings)
   {
     // TODO: Check for collision of binding slots between shader stages.
-    Reflect(vertexShader);
-    Reflect(fragmentShader);
+    Reflect(pendingLink->VertexShader);
+    Reflect(pendingLink->FragmentShader);
   }
+
+  pendingLink.reset();
 }
 
 void GLProgram::Reflect(const ShaderSPIRV& shader)
 {
-  ShaderReflector reflector(shader);
-  
-  auto images = reflector.GetSampledImages();
-  for (auto image : images)
+  // Reflection comes with the shader, so this doesn't touch the SPIRV.
+  std::shared_ptr<const ShaderReflection> reflection = ShaderReflector::GetReflection(shader);
+
+  for (const ShaderReflection::Resource& image : reflection->SampledImages)
   {
     if (image.ArraySize == 1)
     {
@@ -68,16 +120,18 @@ void GLProgram::Reflect(const ShaderSPIRV& shader)
     else
     {
       std::vector<int> bindings(image.ArraySize, image.Binding);
-      for (int i = 0; i < image.ArraySize; i++)
+      for (std::uint32_t i = 0; i < image.ArraySize; i++)
         bindings[i] += i;
 
       UploadUniformIntArray(bindings.data(), image.ArraySize, image.Name.c_str());
     }
   }
 
-  auto ubos = reflector.GetUniformBuffers();
-  for (auto ubo : ubos)
+  for (const ShaderReflection::Resource& ubo : reflection->UniformBuffers)
     SetUniformBlock(ubo.Name.c_str(), ubo.Binding);
+
+  for (const ShaderReflection::Resource& block : reflection->PushConstants)
+    SetUniformBlock(block.Name.c_str(), PushConstantBinding);
 }
 
 GLProgram::~GLProgram()
@@ -90,59 +144,187 @@ void GLProgram::Use()
   glUseProgram(program);
 }
 
+GLProgram::UniformHandle GLProgram::GetUniform(const char* name) const
+{
+  auto handle = uniformHandles.find(name);
+  return handle != uniformHandles.end() ? handle->second : InvalidUniform;
+}
+
+GLProgram::UniformHandle GLProgram::GetUniformBlock(const char* name) const
+{
+  auto handle = blockHandles.find(name);
+  return handle != blockHandles.end() ? handle->second : InvalidUniform;
+}
+
+void GLProgram::BuildUniformTable()
+{
+  uniforms.clear();
+  uniformBlocks.clear();
+  uniformHandles.clear();
+  blockHandles.clear();
+
+  GLint count = 0, maxLength = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+  std::string name(std::max(maxLength, 1), '\0');
+  for (GLint i = 0; i < count; i++)
+  {
+    GLsizei length = 0;
+    Uniform uniform;
+    glGetActiveUniform(program, static_cast<GLuint>(i), maxLength, &length, &uniform.Size,
+                       &uniform.Type, name.data());
+    uniform.Name.assign(name.data(), length);
+    uniform.Location = glGetUniformLocation(program, uniform.Name.c_str());
+
+    // Members of uniform blocks are active too, but they are set through buffers.
+    if (uniform.Location < 0)
+      continue;
+
+    if (uniform.Name.ends_with("[0]"))
+      uniform.Name.resize(uniform.Name.size() - 3);
+
+    uniformHandles[uniform.Name] = static_cast<UniformHandle>(uniforms.size());
+    uniforms.push_back(std::move(uniform));
+  }
+
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+
+  name.assign(std::max(maxLength, 1), '\0');
+  for (GLint i = 0; i < count; i++)
+  {
+    GLsizei length = 0;
+    UniformBlock block;
+    block.Index = static_cast<GLuint>(i);
+    glGetActiveUniformBlockName(program, block.Index, maxLength, &length, name.data());
+    glGetActiveUniformBlockiv(program, block.Index, GL_UNIFORM_BLOCK_DATA_SIZE, &block.DataSize);
+    glGetActiveUniformBlockiv(program, block.Index, GL_UNIFORM_BLOCK_BINDING, &block.Binding);
+    block.Name.assign(name.data(), length);
+
+    blockHandles[block.Name] = static_cast<UniformHandle>(uniformBlocks.size());
+    uniformBlocks.push_back(std::move(block));
+  }
+}
+
+bool GLProgram::UpdateUniform(UniformHandle uniform, const void* data, std::size_t size)
+{
+  if (uniform < 0 || uniform >= static_cast<UniformHandle>(uniforms.size()))
+    return false;
+
+  std::vector<std::uint8_t>& value = uniforms[uniform].Value;
+  if (value.size() == size && std::memcmp(value.data(), data, size) == 0)
+    return false;
+
+  const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+  value.assign(bytes, bytes + size);
+  return true;
+}
+
+// Uniforms are set with the glProgramUniform family, so the program doesn't have to be bound.
+void GLProgram::UploadUniformInt(const int value, UniformHandle uniform)
+{
+  if (UpdateUniform(uniform, &value, sizeof(int)))
+    glProgramUniform1i(program, uniforms[uniform].Location, value);
+}
+
+void GLProgram::UploadUniformIntArray(const int* value, std::size_t numElements,
+                                      UniformHandle uniform)
+{
+  if (UpdateUniform(uniform, value, numElements * sizeof(int)))
+    glProgramUniform1iv(program, uniforms[uniform].Location, static_cast<GLsizei>(numElements),
+                        value);
+}
+
+void GLProgram::UploadUniformFloat(const float value, UniformHandle uniform)
+{
+  if (UpdateUniform(uniform, &value, sizeof(float)))
+    glProgramUniform1f(program, uniforms[uniform].Location, value);
+}
+
+void GLProgram::UploadUniformFloat2(const float* value, UniformHandle uniform)
+{
+  if (UpdateUniform(uniform, value, 2 * sizeof(float)))
+    glProgramUniform2fv(program, uniforms[uniform].Location, 1, value);
+}
+
+void GLProgram::UploadUniformFloat3(const float* value, UniformHandle uniform)
+{
+  if (UpdateUniform(uniform, value, 3 * sizeof(float)))
+    glProgramUniform3fv(program, uniforms[uniform].Location, 1, value);
+}
+
+void GLProgram::UploadUniformFloat4(const float* value, UniformHandle uniform)
+{
+  if (UpdateUniform(uniform, value, 4 * sizeof(float)))
+    glProgramUniform4fv(program, uniforms[uniform].Location, 1, value);
+}
+
+void GLProgram::UploadUniformMat4(const float* value, UniformHandle uniform)
+{
+  if (UpdateUniform(uniform, value, 16 * sizeof(float)))
+    glProgramUniformMatrix4fv(program, uniforms[uniform].Location, 1, GL_FALSE, value);
+}
+
+void GLProgram::SetUniformBlock(UniformHandle block, std::size_t binding)
+{
+  if (block < 0 || block >= static_cast<UniformHandle>(uniformBlocks.size()))
+    return;
+
+  UniformBlock& uniformBlock = uniformBlocks[block];
+  if (uniformBlock.Binding == static_cast<GLint>(binding))
+    return;
+
+  glUniformBlockBinding(program, uniformBlock.Index, static_cast<GLuint>(binding));
+  uniformBlock.Binding = static_cast<GLint>(binding);
+}
+
 void GLProgram::UploadUniformInt(const int value, const char* name)
 {
-  GLint location = glGetUniformLocation(program, name);
-  glUniform1i(location, value);
+  UploadUniformInt(value, GetUniform(name));
 }
 
 void GLProgram::UploadUniformIntArray(const int* value, std::size_t numElements, const char* name)
 {
-  GLint location = glGetUniformLocation(program, name);
-  glUniform1iv(location, static_cast<GLsizei>(numElements), value);
+  UploadUniformIntArray(value, numElements, GetUniform(name));
 }
 
 void GLProgram::UploadUniformFloat(const float value, const char* name)
 {
-  GLint location = glGetUniformLocation(program, name);
-  glUniform1f(location, value);
+  UploadUniformFloat(value, GetUniform(name));
 }
 
 void GLProgram::UploadUniformFloat2(const float* value, const char* name)
 {
-  GLint location = glGetUniformLocation(program, name);
-  glUniform2fv(location, 1, value);
+  UploadUniformFloat2(value, GetUniform(name));
 }
 
 void GLProgram::UploadUniformFloat3(const float* value, const char* name)
 {
-  GLint location = glGetUniformLocation(program, name);
-  glUniform3fv(location, 1, value);
+  UploadUniformFloat3(value, GetUniform(name));
 }
 
 void GLProgram::UploadUniformFloat4(const float* value, const char *name)
 {
-  GLint location = glGetUniformLocation(program, name);
-  glUniform4fv(location, 1, value);
+  UploadUniformFloat4(value, GetUniform(name));
 }
 
 void GLProgram::UploadUniformMat4(const float* value, const char *name)
 {
-  GLint location = glGetUniformLocation(program, name);
-  glUniformMatrix4fv(location, 1, GL_FALSE, value);
+  UploadUniformMat4(value, GetUniform(name));
 }
 
 void GLProgram::SetUniformBlock(const char* name, std::size_t binding)
 {
-  unsigned int waves_index = glGetUniformBlockIndex(program, name);
-  glUniformBlockBinding(program, waves_index, binding);
+  SetUniformBlock(GetUniformBlock(name), binding);
 }
 
 // ----- GLComputeProgram -----
-GLComputeProgram::GLComputeProgram(const std::vector<ShaderSPIRV>& computeKernels)
+GLComputeProgram::GLComputeProgram(GLCompiler& compiler, GLProgramBinaryCache& cache,
+                                   const std::vector<ShaderSPIRV>& computeKernels,
+                                   const std::vector<SpecializationConstant>& specialization)
+    : constants(specialization)
 {
-  GLCompiler compiler;
-
   for (auto kernel : computeKernels)
   {
     if (kernel.Stage != ShaderStage::Compute)
@@ -151,29 +333,66 @@ GLComputeProgram::GLComputeProgram(const std::vector<ShaderSPIRV>& computeKernel
       continue;
     }
 
-    GLuint shader = compiler.Compile(kernel);
-    if (!shader)
+    GLuint program = BuildKernel(compiler, cache, kernel);
+    if (!program)
       continue;
 
-    GLuint program = glCreateProgram();
-    glAttachShader(program, shader);
-    glLinkProgram(program);
+    programs[kernel.Name] = program;
+    codeHashes[kernel.Name] = kernel.GetCodeHash();
+  }
+}
 
-    int success;
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success)
-    {
-      constexpr static std::size_t bufferSize = 512;
-      char infoLog[bufferSize];
-      glGetProgramInfoLog(program, bufferSize, nullptr, infoLog);
+bool GLComputeProgram::ReplaceKernel(GLCompiler& compiler, GLProgramBinaryCache& cache,
+                                     std::uint64_t oldCodeHash, std::uint64_t newCodeHash,
+                                     const ShaderSPIRV& kernel)
+{
+  auto hash = codeHashes.find(kernel.Name);
+  if (hash == codeHashes.end() || hash->second != oldCodeHash)
+    return false;
+
+  GLuint program = BuildKernel(compiler, cache, kernel);
+  if (!program)
+    return false;
+
+  glDeleteProgram(programs[kernel.Name]);
+  programs[kernel.Name] = program;
+  hash->second = newCodeHash;
+  return true;
+}
 
-      std::cout << "Failed to link shader program with shader: " << kernel.Name << std::endl;
-      std::cout << infoLog << std::endl;
-    }
+GLuint GLComputeProgram::BuildKernel(GLCompiler& compiler, GLProgramBinaryCache& cache,
+                                     const ShaderSPIRV& kernel)
+{
+  std::uint64_t key = cache.ComputeKey({&kernel}, 450, constants);
+  GLuint program = cache.Load(key);
+  if (program)
+    return program;
 
-    programs[kernel.Name] = program;
-    glDeleteShader(shader);
+  GLuint shader = compiler.Compile(kernel, 450, true, constants);
+  if (!shader)
+    return 0;
+
+  program = glCreateProgram();
+  glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  glAttachShader(program, shader);
+  glLinkProgram(program);
+
+  int success;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  if (!success)
+  {
+    constexpr static std::size_t bufferSize = 512;
+    char infoLog[bufferSize];
+    glGetProgramInfoLog(program, bufferSize, nullptr, infoLog);
+
+    std::cout << "Failed to link shader program with shader: " << kernel.Name << std::endl;
+    std::cout << infoLog << std::endl;
   }
+  else
+    cache.Store(key, program);
+
+  glDeleteShader(shader);
+  return program;
 }
 
 GLComputeProgram::~GLComputeProgram()
@@ -1,7 +1,11 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "renderer/primitive/Buffer.h"
 #include "renderer/primitive/Pipeline.h"
@@ -11,18 +15,70 @@
 namespace Vision
 {
 
+class GLCompiler;
+class GLProgramBinaryCache;
+
 // ----- GLProgram -----
 
 class GLProgram
 {
 public:
   GLProgram() = default;
-  GLProgram(const ShaderSPIRV& vertexShader, const ShaderSPIRV& fragmentShader, bool manualBinding);
+  GLProgram(GLCompiler& compiler, GLProgramBinaryCache& cache, const ShaderSPIRV& vertexShader,
+            const ShaderSPIRV& fragmentShader, const std::vector<SpecializationConstant>& constants,
+            bool manualBinding, bool waitForLink = true);
   ~GLProgram();
 
+  // When created without waiting, the link may still be running on the driver. FinishLink blocks
+  // until it is done and must be called before the program is used.
+  bool IsLinkPending() const { return pendingLink != nullptr; }
+  void FinishLink();
+
+  // False if the link failed, or hasn't finished yet
+  bool IsLinked() const { return linked; }
+
   void Use();
   GLuint GetProgram() const { return program; }
 
+  // Every active uniform and block is recorded when the program links. Handles index that table,
+  // so uploading through one never asks the driver to look up a name. Invalid handles are ignored,
+  // as are uploads of the value the uniform already holds.
+  using UniformHandle = int;
+  static constexpr UniformHandle InvalidUniform = -1;
+
+  struct Uniform
+  {
+    std::string Name; // arrays are listed without their [0]
+    GLint Location;
+    GLenum Type;
+    GLint Size; // number of array elements
+    std::vector<std::uint8_t> Value; // last upload, empty until the first
+  };
+
+  struct UniformBlock
+  {
+    std::string Name;
+    GLuint Index;
+    GLint DataSize;
+    GLint Binding;
+  };
+
+  UniformHandle GetUniform(const char* name) const;
+  UniformHandle GetUniformBlock(const char* name) const;
+  const std::vector<Uniform>& GetUniforms() const { return uniforms; }
+  const std::vector<UniformBlock>& GetUniformBlocks() const { return uniformBlocks; }
+
+  void SetUniformBlock(UniformHandle block, std::size_t binding);
+
+  void UploadUniformInt(const int, UniformHandle uniform);
+  void UploadUniformIntArray(const int *, std::size_t numElements, UniformHandle uniform);
+  void UploadUniformFloat(const float, UniformHandle uniform);
+  void UploadUniformFloat2(const float *, UniformHandle uniform);
+  void UploadUniformFloat3(const float *, UniformHandle uniform);
+  void UploadUniformFloat4(const float *, UniformHandle uniform);
+  void UploadUniformMat4(const float *, UniformHandle uniform);
+
+  // Convenience versions that look the handle up first
   void SetUniformBlock(const char *name, std::size_t binding);
 
   void UploadUniformInt(const int, const char *name);
@@ -34,10 +90,30 @@ public:
   void UploadUniformMat4(const float *, const char *name);
 
 private:
+  void BuildUniformTable();
   void Reflect(const ShaderSPIRV& shader);
 
+  // Records the value and returns whether it differs from the last upload.
+  bool UpdateUniform(UniformHandle uniform, const void* data, std::size_t size);
+
 private:
   GLuint program = 0;
+  bool linked = false;
+
+  std::vector<Uniform> uniforms;
+  std::vector<UniformBlock> uniformBlocks;
+  std::unordered_map<std::string, UniformHandle> uniformHandles;
+  std::unordered_map<std::string, UniformHandle> blockHandles;
+
+  struct PendingLink
+  {
+    GLProgramBinaryCache* Cache;
+    std::uint64_t Key;
+    ShaderSPIRV VertexShader, FragmentShader;
+    GLuint VS, FS;
+    bool ManualBindings;
+  };
+  std::unique_ptr<PendingLink> pendingLink;
 };
 
 // ----- GLComputeProgram -----
@@ -50,13 +126,25 @@ private:
 class GLComputeProgram
 {
 public:
-  GLComputeProgram(const std::vector<ShaderSPIRV>& kernels);
+  GLComputeProgram(GLCompiler& compiler, GLProgramBinaryCache& cache,
+                   const std::vector<ShaderSPIRV>& kernels,
+                   const std::vector<SpecializationConstant>& constants = {});
   ~GLComputeProgram();
 
   void Use(const std::string& kernel);
+  GLuint GetProgram(const std::string& kernel) { return programs[kernel]; }
+
+  // Rebuilds the kernel of the same name if it is currently running the old code.
+  bool ReplaceKernel(GLCompiler& compiler, GLProgramBinaryCache& cache, std::uint64_t oldCodeHash,
+                     std::uint64_t newCodeHash, const ShaderSPIRV& kernel);
+
+private:
+  GLuint BuildKernel(GLCompiler& compiler, GLProgramBinaryCache& cache, const ShaderSPIRV& kernel);
 
 private:
   std::unordered_map<std::string, GLuint> programs;
+  std::unordered_map<std::string, std::uint64_t> codeHashes;
+  std::vector<SpecializationConstant> constants; // reapplied when a kernel is replaced
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "GLProgramCache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "core/Hash.h"
+
+namespace Vision
+{
+
+// Bump whenever the way programs are built changes without the SPIRV changing.
+constexpr std::uint32_t programCacheVersion = 2;
+constexpr std::uint32_t programCacheMagic = 0x504c4756; // "VGLP"
+
+struct ProgramCacheHeader
+{
+  std::uint32_t Magic;
+  std::uint32_t Version;
+  std::uint64_t Key;
+  std::uint64_t PayloadHash;
+  std::uint32_t Format;
+  std::uint32_t Length;
+};
+
+GLProgramBinaryCache::GLProgramBinaryCache(const std::string& dir)
+    : directory(dir)
+{
+}
+
+void GLProgramBinaryCache::Initialize()
+{
+  GLint numFormats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+  if (numFormats <= 0)
+    return;
+
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error)
+  {
+    std::cout << "Warning: unable to create program cache folder " << directory << std::endl;
+    return;
+  }
+
+  const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+  const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+  deviceKey = Hash64(version ? version : "", HashSeed);
+  deviceKey = Hash64(renderer ? renderer : "", deviceKey);
+  enabled = true;
+}
+
+std::uint64_t
+GLProgramBinaryCache::ComputeKey(std::initializer_list<const ShaderSPIRV*> shaders,
+                                 uint32_t glslVersion,
+                                 const std::vector<SpecializationConstant>& constants) const
+{
+  std::uint64_t key = Hash64Value(programCacheVersion, deviceKey);
+  key = Hash64Value(glslVersion, key);
+  key = HashSpecialization(constants, key);
+  for (const ShaderSPIRV* shader : shaders)
+  {
+    key = Hash64Value(shader->Stage, key);
+    key = Hash64(shader->GetCode().data(), shader->GetCode().size_bytes(), key);
+  }
+  return key;
+}
+
+std::string GLProgramBinaryCache::GetEntryPath(std::uint64_t key) const
+{
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+  return directory + "/" + name;
+}
+
+bool GLProgramBinaryCache::Contains(std::uint64_t key) const
+{
+  std::error_code error;
+  return enabled && std::filesystem::exists(GetEntryPath(key), error);
+}
+
+GLuint GLProgramBinaryCache::Load(std::uint64_t key)
+{
+  if (!enabled)
+    return 0;
+
+  std::ifstream file(GetEntryPath(key), std::ios::binary | std::ios::in);
+  ProgramCacheHeader header;
+  if (!file.is_open() || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      header.Magic != programCacheMagic || header.Version != programCacheVersion ||
+      header.Key != key)
+  {
+    misses++;
+    return 0;
+  }
+
+  std::vector<char> binary(header.Length);
+  if (!file.read(binary.data(), binary.size()) ||
+      Hash64(binary.data(), binary.size()) != header.PayloadHash)
+  {
+    misses++;
+    return 0;
+  }
+
+  GLuint program = glCreateProgram();
+  glProgramBinary(program, header.Format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+  GLint success = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  if (!success)
+  {
+    glDeleteProgram(program);
+    rejected++;
+    misses++;
+    return 0;
+  }
+
+  hits++;
+  return program;
+}
+
+void GLProgramBinaryCache::Store(std::uint64_t key, GLuint program)
+{
+  if (!enabled)
+    return;
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+
+  std::vector<char> binary(length);
+  GLenum format = 0;
+  glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+  ProgramCacheHeader header;
+  header.Magic = programCacheMagic;
+  header.Version = programCacheVersion;
+  header.Key = key;
+  header.PayloadHash = Hash64(binary.data(), binary.size());
+  header.Format = format;
+  header.Length = static_cast<std::uint32_t>(length);
+
+  // Programs are only ever built on the render thread, so one temporary name is enough.
+  std::string path = GetEntryPath(key);
+  std::string tempPath = path + ".tmp";
+  {
+    std::ofstream stream(tempPath, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!stream.is_open())
+      return;
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(binary.data(), binary.size());
+  }
+
+  std::error_code error;
+  std::filesystem::rename(tempPath, path, error);
+  if (error)
+    std::filesystem::remove(tempPath, error);
+}
+
+} // namespace Vision
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <glad/glad.h>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "renderer/shader/Shader.h"
+
+namespace Vision
+{
+
+// Persists linked programs with glGetProgramBinary so a warm start skips the driver's compile and
+// link. Binaries are only valid for the driver that produced them, so the key folds in GL_VERSION
+// and GL_RENDERER alongside the SPIRV of every stage. A binary the driver refuses (after a driver
+// update, for instance) is counted as rejected and the caller simply falls back to a full build.
+class GLProgramBinaryCache
+{
+public:
+  GLProgramBinaryCache(const std::string& directory = "cache/glprogram");
+
+  // Must be called once a context is current. Leaves the cache disabled if the driver doesn't
+  // expose any binary formats.
+  void Initialize();
+  bool IsEnabled() const { return enabled; }
+
+  std::uint64_t ComputeKey(std::initializer_list<const ShaderSPIRV*> shaders, uint32_t glslVersion,
+                           const std::vector<SpecializationConstant>& constants = {}) const;
+
+  // Only checks for an entry on disk, so unlike Load it is safe to call from any thread.
+  bool Contains(std::uint64_t key) const;
+
+  // Returns a linked program, or zero on a miss.
+  GLuint Load(std::uint64_t key);
+  void Store(std::uint64_t key, GLuint program);
+
+  std::size_t GetHits() const { return hits; }
+  std::size_t GetMisses() const { return misses; }
+  std::size_t GetRejected() const { return rejected; }
+
+private:
+  std::string GetEntryPath(std::uint64_t key) const;
+
+private:
+  std::string directory;
+  std::uint64_t deviceKey = 0;
+  bool enabled = false;
+
+  std::size_t hits = 0;
+  std::size_t misses = 0;
+  std::size_t rejected = 0;
+};
+
+} // namespace Vision
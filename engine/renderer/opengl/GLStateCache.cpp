@@ -0,0 +1,182 @@
+#include "GLStateCache.h"
+
+namespace Vision
+{
+
+void GLStateCache::UseProgram(GLuint id)
+{
+  if (Update(program, id))
+    glUseProgram(id);
+}
+
+void GLStateCache::BindVertexArray(GLuint id)
+{
+  if (Update(vertexArray, id))
+    glBindVertexArray(id);
+}
+
+void GLStateCache::BindIndexBuffer(GLuint buffer)
+{
+  // without a known vertex array there is nowhere to record the binding
+  if (!vertexArray)
+  {
+    counters.Issued++;
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+    return;
+  }
+
+  auto bound = indexBuffers.find(*vertexArray);
+  if (bound != indexBuffers.end() && bound->second == buffer)
+  {
+    counters.Skipped++;
+    return;
+  }
+
+  indexBuffers[*vertexArray] = buffer;
+  counters.Issued++;
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+}
+
+void GLStateCache::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset,
+                                   GLsizeiptr size)
+{
+  std::uint64_t key = (static_cast<std::uint64_t>(target) << 32) | index;
+  BufferRange range = {buffer, offset, size};
+
+  auto bound = bufferRanges.find(key);
+  if (bound != bufferRanges.end() && bound->second == range)
+  {
+    counters.Skipped++;
+    return;
+  }
+
+  bufferRanges[key] = range;
+  counters.Issued++;
+  glBindBufferRange(target, index, buffer, offset, size);
+}
+
+void GLStateCache::BindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+  if (unit >= maxTextureUnits)
+  {
+    if (Update(activeUnit, unit))
+      glActiveTexture(GL_TEXTURE0 + unit);
+
+    counters.Issued++;
+    glBindTexture(target, texture);
+    return;
+  }
+
+  TextureUnit& textureUnit = textureUnits[unit];
+  std::optional<GLuint>& bound =
+      target == GL_TEXTURE_CUBE_MAP ? textureUnit.Cubemap : textureUnit.Texture2D;
+  if (!Update(bound, texture))
+    return;
+
+  if (Update(activeUnit, unit))
+    glActiveTexture(GL_TEXTURE0 + unit);
+  glBindTexture(target, texture);
+}
+
+void GLStateCache::SetEnabled(GLenum capability, bool enabled)
+{
+  auto current = capabilities.find(capability);
+  if (current != capabilities.end() && current->second == enabled)
+  {
+    counters.Skipped++;
+    return;
+  }
+
+  capabilities[capability] = enabled;
+  counters.Issued++;
+  if (enabled)
+    glEnable(capability);
+  else
+    glDisable(capability);
+}
+
+void GLStateCache::SetDepthMask(bool write)
+{
+  if (Update(depthMask, write))
+    glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void GLStateCache::SetDepthFunc(GLenum func)
+{
+  if (Update(depthFunc, func))
+    glDepthFunc(func);
+}
+
+void GLStateCache::SetBlendFunc(GLenum source, GLenum destination)
+{
+  std::uint64_t funcs = (static_cast<std::uint64_t>(source) << 32) | destination;
+  if (Update(blendFunc, funcs))
+    glBlendFunc(source, destination);
+}
+
+void GLStateCache::SetPolygonMode(GLenum mode)
+{
+  if (Update(polygonMode, mode))
+    glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void GLStateCache::SetViewport(const glm::ivec4& rect)
+{
+  if (Update(viewport, rect))
+    glViewport(rect.x, rect.y, rect.z, rect.w);
+}
+
+void GLStateCache::SetScissor(const glm::ivec4& rect)
+{
+  if (Update(scissor, rect))
+    glScissor(rect.x, rect.y, rect.z, rect.w);
+}
+
+void GLStateCache::NoteBufferBound(GLenum target)
+{
+  if (target != GL_ELEMENT_ARRAY_BUFFER)
+    return;
+
+  if (vertexArray)
+    indexBuffers.erase(*vertexArray);
+  else
+    indexBuffers.clear();
+}
+
+void GLStateCache::NoteTextureBound()
+{
+  if (activeUnit && *activeUnit < maxTextureUnits)
+  {
+    textureUnits[*activeUnit] = TextureUnit();
+    return;
+  }
+
+  for (TextureUnit& unit : textureUnits)
+    unit = TextureUnit();
+}
+
+void GLStateCache::ForgetBuffer(GLuint buffer)
+{
+  std::erase_if(indexBuffers, [buffer](const auto& pair) { return pair.second == buffer; });
+  std::erase_if(bufferRanges, [buffer](const auto& pair) { return pair.second.Buffer == buffer; });
+}
+
+void GLStateCache::ForgetTexture(GLuint texture)
+{
+  for (TextureUnit& unit : textureUnits)
+  {
+    if (unit.Texture2D == texture)
+      unit.Texture2D.reset();
+    if (unit.Cubemap == texture)
+      unit.Cubemap.reset();
+  }
+}
+
+void GLStateCache::ForgetVertexArray(GLuint id)
+{
+  indexBuffers.erase(id);
+  if (vertexArray == id)
+    vertexArray.reset();
+}
+
+} // namespace Vision
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <optional>
+#include <unordered_map>
+
+namespace Vision
+{
+
+// Shadows the GL state the device sets for draws and dispatches, so only calls that change
+// something reach the driver. Everything starts out unknown, which always issues the call.
+//
+// State that is changed behind the cache's back (object creation and uploads bind to the generic
+// targets) has to be reported with the Note/Forget functions, otherwise a needed call is skipped.
+class GLStateCache
+{
+public:
+  struct Counters
+  {
+    std::size_t Issued = 0;
+    std::size_t Skipped = 0;
+  };
+
+  void UseProgram(GLuint program);
+  void BindVertexArray(GLuint vertexArray);
+  void BindIndexBuffer(GLuint buffer); // part of the bound vertex array's state
+  void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset,
+                       GLsizeiptr size);
+  void BindTexture(GLuint unit, GLenum target, GLuint texture);
+
+  void SetEnabled(GLenum capability, bool enabled);
+  void SetDepthMask(bool write);
+  void SetDepthFunc(GLenum func);
+  void SetBlendFunc(GLenum source, GLenum destination);
+  void SetPolygonMode(GLenum mode);
+  void SetViewport(const glm::ivec4& rect);
+  void SetScissor(const glm::ivec4& rect);
+
+  // Something bound a buffer to the target directly. Only index buffers matter to us.
+  void NoteBufferBound(GLenum target);
+
+  // Something bound textures to the active unit directly.
+  void NoteTextureBound();
+
+  // GL reuses names, so deleted objects must be forgotten or a new one could be skipped.
+  void ForgetBuffer(GLuint buffer);
+  void ForgetTexture(GLuint texture);
+  void ForgetVertexArray(GLuint vertexArray);
+
+  const Counters& GetCounters() const { return counters; }
+  void ResetCounters() { counters = Counters(); }
+
+private:
+  // Records the value and returns true if the call has to be issued
+  template <typename T> bool Update(std::optional<T>& cached, const T& value)
+  {
+    if (cached == value)
+    {
+      counters.Skipped++;
+      return false;
+    }
+
+    cached = value;
+    counters.Issued++;
+    return true;
+  }
+
+private:
+  static constexpr GLuint maxTextureUnits = 32;
+
+  struct TextureUnit
+  {
+    std::optional<GLuint> Texture2D;
+    std::optional<GLuint> Cubemap;
+  };
+
+  struct BufferRange
+  {
+    GLuint Buffer;
+    GLintptr Offset;
+    GLsizeiptr Size;
+
+    bool operator==(const BufferRange& other) const = default;
+  };
+
+  std::optional<GLuint> program;
+  std::optional<GLuint> vertexArray;
+  std::unordered_map<GLuint, GLuint> indexBuffers; // per vertex array
+  std::unordered_map<std::uint64_t, BufferRange> bufferRanges; // keyed by target and index
+
+  std::optional<GLuint> activeUnit;
+  TextureUnit textureUnits[maxTextureUnits];
+
+  std::unordered_map<GLenum, bool> capabilities;
+  std::optional<bool> depthMask;
+  std::optional<GLenum> depthFunc;
+  std::optional<std::uint64_t> blendFunc;
+  std::optional<GLenum> polygonMode;
+  std::optional<glm::ivec4> viewport;
+  std::optional<glm::ivec4> scissor;
+
+  Counters counters;
+};
+
+} // namespace Vision
@@ -52,6 +52,8 @@ public:
   GLCubemap(const CubemapDesc& desc);
   ~GLCubemap();
 
+  GLuint GetGLID() const { return m_CubemapID; }
+
   void Bind(uint32_t index = 0);
   void Unbind();
 
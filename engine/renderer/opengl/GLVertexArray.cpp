@@ -1,5 +1,7 @@
 #include "GLVertexArray.h"
 
+#include <algorithm>
+
 #include "GLDevice.h"
 
 namespace Vision
@@ -42,9 +44,18 @@ void GLVertexArray::AttachBuffer(GLBuffer* buffer, const BufferLayout& layout)
 
   for (auto& element : layout.Elements)
   {
-    glVertexAttribPointer(m_CurrentAttrib, ShaderDataTypeCount(element.Type),
-                          GLenumFromShaderDataType(element.Type), element.Normalized, layout.Stride,
-                          (void*)element.Offset);
+    if (element.Location != BufferElement::NextLocation)
+      m_CurrentAttrib = element.Location;
+
+    // Integer inputs need the I variant, otherwise the driver converts the data to floats
+    if (element.Type == ShaderDataType::Int)
+      glVertexAttribIPointer(m_CurrentAttrib, ShaderDataTypeCount(element.Type),
+                             GLenumFromShaderDataType(element.Type), layout.Stride,
+                             (void*)(buffer->GetRegionOffset() + element.Offset));
+    else
+      glVertexAttribPointer(m_CurrentAttrib, ShaderDataTypeCount(element.Type),
+                            GLenumFromShaderDataType(element.Type), element.Normalized,
+                            layout.Stride, (void*)(buffer->GetRegionOffset() + element.Offset));
     glVertexAttribDivisor(m_CurrentAttrib, element.InstanceDivisor);
     glEnableVertexAttribArray(m_CurrentAttrib);
 
@@ -77,54 +88,59 @@ template <typename T> void HashCombine(std::size_t& Seed, const T& Val) noexcept
 //   return Seed;
 // }
 
-// we'll profile this later. just want to ensure we don't have
-// collisions because we aren't hashing the right values.
-GLVertexArray* GLVertexArrayCache::Fetch(GLDevice* device, ID pipeline, std::vector<ID> vbos)
+// A vertex array only depends on the layouts and the buffers, so pipelines with the same layouts
+// share them. The layouts are hashed once, when the pipeline is created. Persistent buffers bake
+// their current region into the attribute offsets, so the regions are hashed too.
+GLVertexArray* GLVertexArrayCache::Fetch(GLDevice* device, ID pipeline, std::span<const ID> vbos)
 {
-  // TODO: We really should be hashing the IDs of our pipelines.
-  std::size_t hash = 0;
-  HashCombine(hash, pipeline);
-
   GLPipeline* pipeObj = device->GetPipeline(pipeline);
 
-  for (auto layout : pipeObj->Layouts)
-  {
-    HashCombine(hash, layout.Stride);
-    for (auto element : layout.Elements)
-    {
-      HashCombine(hash, element.InstanceDivisor);
-      HashCombine(hash, element.Normalized);
-      HashCombine(hash, element.Offset);
-      HashCombine(hash, element.Size);
-      HashCombine(hash, element.Type);
-    }
-  }
-
-  for (auto buffer : vbos)
+  std::size_t hash = 0;
+  HashCombine(hash, pipeObj->LayoutHash);
+  for (ID buffer : vbos)
   {
     HashCombine(hash, buffer);
+    HashCombine(hash, device->GetBuffer(buffer)->GetRegion());
   }
 
   auto vao = vaos.find(hash);
   if (vao != vaos.end())
   {
-    return vao->second;
+    return vao->second.VAO;
   }
   else
   {
-    GLVertexArray* vao = new GLVertexArray();
+    Entry entry;
+    entry.VAO = new GLVertexArray();
     int layoutNum = 0;
-    for (auto buffer : vbos)
+    for (ID buffer : vbos)
     {
-      vao->AttachBuffer(device->GetBuffer(buffer), pipeObj->Layouts[layoutNum]);
+      entry.VAO->AttachBuffer(device->GetBuffer(buffer), pipeObj->Layouts[layoutNum]);
+      entry.Buffers.push_back(buffer);
       layoutNum++;
     }
 
-    vaos.emplace(hash, vao);
-    return vao;
+    vaos.emplace(hash, entry);
+    return entry.VAO;
   }
 }
 
+void GLVertexArrayCache::Forget(ID buffer, GLStateCache& stateCache)
+{
+  std::erase_if(vaos,
+                [buffer, &stateCache](const auto& pair)
+                {
+                  const Entry& entry = pair.second;
+                  if (std::find(entry.Buffers.begin(), entry.Buffers.end(), buffer) ==
+                      entry.Buffers.end())
+                    return false;
+
+                  stateCache.ForgetVertexArray(entry.VAO->GetID());
+                  delete entry.VAO;
+                  return true;
+                });
+}
+
 void GLVertexArrayCache::Clear()
 {
   vaos.clear();
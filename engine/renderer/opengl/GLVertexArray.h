@@ -1,11 +1,14 @@
 #pragma once
 
 #include <glad/glad.h>
-#include <vector>
+#include <span>
 #include <unordered_map>
 
 #include "GLPipeline.h"
 #include "GLBuffer.h"
+#include "GLStateCache.h"
+#include "core/InlineVector.h"
+#include "renderer/RenderCommand.h"
 
 namespace Vision
 {
@@ -20,8 +23,10 @@ public:
   ~GLVertexArray();
 
   void Bind();
+  GLuint GetID() const { return m_Object; }
 
-  // Buffers are attached in the shader in order of this call 
+  // Buffers are attached in the shader in order of this call. Attribute offsets include the
+  // buffer's current region, so a vertex array is only valid while the regions stay the same.
   void AttachBuffer(GLBuffer* buffer, const BufferLayout& layout);
 
 private:
@@ -37,12 +42,21 @@ private:
 struct GLVertexArrayCache
 {
 public:
-  GLVertexArray* Fetch(GLDevice* device, ID pipeline, std::vector<ID> vbos);
+  GLVertexArray* Fetch(GLDevice* device, ID pipeline, std::span<const ID> vbos);
+
+  // Deletes the vertex arrays that use the buffer, when it is destroyed or gets a new name
+  void Forget(ID buffer, GLStateCache& stateCache);
 
   void Clear();
 
 private:
-  std::unordered_map<std::size_t, GLVertexArray*> vaos;
+  struct Entry
+  {
+    GLVertexArray* VAO;
+    InlineVector<ID, DrawCommand::MaxVertexBuffers> Buffers;
+  };
+
+  std::unordered_map<std::size_t, Entry> vaos;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "BufferLayout.h"
+
+#include <iostream>
+#include <map>
+
+namespace Vision
+{
+
+static bool ShaderDataTypeFromInput(const ShaderReflection::VertexInput& input,
+                                    ShaderDataType& type)
+{
+  if (input.Type == ShaderReflection::BaseType::Int && input.Components == 1)
+  {
+    type = ShaderDataType::Int;
+    return true;
+  }
+
+  if (input.Type != ShaderReflection::BaseType::Float)
+    return false;
+
+  switch (input.Components)
+  {
+    case 1: type = ShaderDataType::Float; return true;
+    case 2: type = ShaderDataType::Float2; return true;
+    case 3: type = ShaderDataType::Float3; return true;
+    case 4: type = ShaderDataType::Float4; return true;
+    default: return false;
+  }
+}
+
+BufferLayout BufferLayout::FromReflection(const ShaderReflection& reflection)
+{
+  BufferLayout layout;
+
+  for (const ShaderReflection::VertexInput& input : reflection.VertexInputs)
+  {
+    ShaderDataType type;
+    if (!ShaderDataTypeFromInput(input, type))
+    {
+      std::cout << "Unable to derive a vertex format for input: " << input.Name << std::endl;
+      continue;
+    }
+
+    // Matrices take one location per column
+    for (std::uint32_t column = 0; column < input.Columns; column++)
+    {
+      std::string name = input.Name;
+      if (input.Columns > 1)
+        name += "[" + std::to_string(column) + "]";
+
+      BufferElement element(type, name);
+      element.Location = input.Location + column;
+      layout.Elements.push_back(element);
+    }
+  }
+
+  layout.CalculateOffsetsAndStride();
+  return layout;
+}
+
+bool ValidateBufferLayouts(const std::vector<BufferLayout>& layouts,
+                           const ShaderReflection& reflection, const std::string& shaderName)
+{
+  // What the shader reads at each location
+  struct Slot
+  {
+    const ShaderReflection::VertexInput* Input;
+    bool Fed = false;
+  };
+
+  std::map<std::uint32_t, Slot> slots;
+  for (const ShaderReflection::VertexInput& input : reflection.VertexInputs)
+    for (std::uint32_t column = 0; column < input.Columns; column++)
+      slots[input.Location + column].Input = &input;
+
+  bool valid = true;
+  auto report = [&](const std::string& message)
+  {
+    std::cout << "Vertex layout mismatch in " << shaderName << ": " << message << std::endl;
+    valid = false;
+  };
+
+  std::uint32_t location = 0;
+  for (const BufferLayout& layout : layouts)
+  {
+    for (const BufferElement& element : layout.Elements)
+    {
+      if (element.Location != BufferElement::NextLocation)
+        location = element.Location;
+
+      auto slot = slots.find(location);
+      if (slot == slots.end())
+      {
+        report(element.Name + " feeds location " + std::to_string(location) +
+               ", which the shader doesn't read");
+      }
+      else
+      {
+        const ShaderReflection::VertexInput& input = *slot->second.Input;
+        bool integer = element.Type == ShaderDataType::Int;
+        bool shaderInteger = input.Type == ShaderReflection::BaseType::Int ||
+                             input.Type == ShaderReflection::BaseType::UInt;
+
+        if (slot->second.Fed)
+          report(element.Name + " feeds location " + std::to_string(location) +
+                 ", which is already fed by another element");
+        else if (integer != shaderInteger)
+          report(element.Name + " and " + input.Name + " disagree on integer vs float data");
+        else if (static_cast<std::uint32_t>(ShaderDataTypeCount(element.Type)) > input.Components)
+          report(element.Name + " supplies " + std::to_string(ShaderDataTypeCount(element.Type)) +
+                 " components, but " + input.Name + " only reads " +
+                 std::to_string(input.Components));
+
+        slot->second.Fed = true;
+      }
+
+      location++;
+    }
+  }
+
+  // Unfed inputs read a constant default, which is almost never what was intended.
+  for (const auto& [slotLocation, slot] : slots)
+  {
+    if (!slot.Fed)
+      report(slot.Input->Name + " at location " + std::to_string(slotLocation) +
+             " isn't fed by any layout");
+  }
+
+  return valid;
+}
+
+} // namespace Vision
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <initializer_list>
 
 #include <glad/glad.h>
 
+#include "renderer/shader/ShaderReflection.h"
+
 namespace Vision 
 {
 
@@ -71,6 +74,11 @@ struct BufferElement
   std::size_t Offset;
   std::size_t Size;
 
+  // The shader location this element feeds. By default it is the one after the previous element,
+  // counting across every layout of the pipeline, which matches shaders that number their inputs.
+  static constexpr std::uint32_t NextLocation = ~0u;
+  std::uint32_t Location = NextLocation;
+
   BufferElement(ShaderDataType type, const std::string &name, bool normalized = false, std::size_t instanceDivisor = 0)
       : Type(type), Name(name), Normalized(normalized), Offset(0), Size(ShaderDataTypeSize(type)), InstanceDivisor(instanceDivisor) {}
 };
@@ -99,6 +107,16 @@ struct BufferLayout
   }
 
   BufferLayout() = default;
+
+  // Builds a layout with one element per input of a vertex shader, in location order and tightly
+  // packed. Every supported type is made of 4 byte components, so this never needs padding, and
+  // the matching vertex struct is just the inputs declared in order.
+  static BufferLayout FromReflection(const ShaderReflection& reflection);
 };
 
+// Checks that a pipeline's layouts feed every input of its vertex shader with a compatible type,
+// and nothing else. Problems are printed and make this return false; the pipeline still builds.
+bool ValidateBufferLayouts(const std::vector<BufferLayout>& layouts,
+                           const ShaderReflection& reflection, const std::string& shaderName);
+
 }
\ No newline at end of file
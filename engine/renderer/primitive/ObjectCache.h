@@ -31,6 +31,9 @@ public:
   T* Get(ID id) { return cache.at(id); }
   void Destroy(ID id) { delete cache[id]; cache.erase(id); }
 
+  auto begin() { return cache.begin(); }
+  auto end() { return cache.end(); }
+
 private:
   std::unordered_map<ID, T*> cache;
 };
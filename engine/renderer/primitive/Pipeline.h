@@ -31,6 +31,10 @@ struct RenderPipelineDesc
   // VBO Layouts
   std::vector<BufferLayout> Layouts;
 
+  // Ignores Layouts and uses a single buffer laid out to match the vertex shader's inputs (see
+  // BufferLayout::FromReflection). Hand-written layouts are checked against the shader in debug.
+  bool DeriveLayout = false;
+
   // Shaders
   ShaderSPIRV VertexShader;
   ShaderSPIRV PixelShader;
@@ -50,6 +54,9 @@ struct RenderPipelineDesc
   ShaderSPIRV HullShader;
   ShaderSPIRV DomainShader;
 
+  // Applied to every stage before it is handed to the driver, so it only sees folded constants
+  std::vector<SpecializationConstant> Constants;
+
   RenderPipelineDesc() // default ctor to automatically set pixel format
       : PixelType(PixelType::BGRA8)
   {
@@ -59,6 +66,9 @@ struct RenderPipelineDesc
 struct ComputePipelineDesc
 {
   std::vector<ShaderSPIRV> ComputeKernels;
+
+  // Applied to every kernel, e.g. to pick workgroup sizes declared with local_size_x_id
+  std::vector<SpecializationConstant> Constants;
 };
 
 } // namespace Vision
\ No newline at end of file
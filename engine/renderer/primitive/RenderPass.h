@@ -28,6 +28,10 @@ struct RenderPassDesc
   glm::vec4 ClearColor;
   StoreOp StoreOp = StoreOp::Store;
 
+  // Devices that record and sort draws (GL) replay this pass's draws exactly as submitted. Draws
+  // that blend are always kept in order, so this is for passes whose opaque draws depend on it.
+  bool PreserveOrder = false;
+
   // TODO: Subpasses
 };
 
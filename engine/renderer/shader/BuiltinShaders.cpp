@@ -0,0 +1,32 @@
+#include "BuiltinShaders.h"
+
+#include <SDL.h>
+#include <iostream>
+
+// Generated by visionc from engine/shaders/*.glsl, see engine/CMakeLists.txt.
+#include "BuiltinShaderPack.h"
+
+namespace Vision
+{
+
+std::shared_ptr<ShaderPack> GetBuiltinShaderPack()
+{
+  static std::shared_ptr<ShaderPack> pack =
+      ShaderPack::FromMemory(BuiltinShaderPack, sizeof(BuiltinShaderPack));
+  return pack;
+}
+
+ShaderSPIRV GetBuiltinShader(const std::string& name, ShaderStage stage)
+{
+  ShaderSPIRV shader;
+  std::shared_ptr<ShaderPack> pack = GetBuiltinShaderPack();
+  if (!pack || !pack->FindShader(name, stage, shader))
+  {
+    std::cout << "Missing built-in shader: " << name << std::endl;
+    SDL_assert(false);
+  }
+
+  return shader;
+}
+
+} // namespace Vision
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "Shader.h"
+#include "ShaderPack.h"
+
+namespace Vision
+{
+
+// The shaders used by the engine itself (Renderer2D, ImGuiRenderer) live in engine/shaders and are
+// compiled by visionc at build time. The resulting pack is embedded in the library, so creating
+// the built-in pipelines never has to run glslang.
+std::shared_ptr<ShaderPack> GetBuiltinShaderPack();
+ShaderSPIRV GetBuiltinShader(const std::string& name, ShaderStage stage);
+
+} // namespace Vision
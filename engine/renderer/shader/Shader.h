@@ -1,8 +1,17 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
+#include "core/Hash.h"
+
+#include "ShaderReflection.h"
+
 namespace Vision
 {
 
@@ -22,8 +31,58 @@ struct ShaderSource
   ShaderStage Stage;
   std::string Name;
   std::string Source;
+
+  // Every file pulled in through #include while expanding this section.
+  std::vector<std::string> Dependencies;
 };
 
+// Overrides the default of a specialization constant, layout(constant_id = ID) in GLSL. This also
+// covers workgroup sizes declared with local_size_x_id and friends. Value holds the raw 32 bits of
+// the constant, so floats go through FromFloat.
+struct SpecializationConstant
+{
+  std::uint32_t ID;
+  std::uint32_t Value;
+
+  static SpecializationConstant FromFloat(std::uint32_t id, float value)
+  {
+    return {id, std::bit_cast<std::uint32_t>(value)};
+  }
+};
+
+inline std::uint64_t HashSpecialization(const std::vector<SpecializationConstant>& constants,
+                                        std::uint64_t seed)
+{
+  for (const SpecializationConstant& constant : constants)
+  {
+    seed = Hash64Value(constant.ID, seed);
+    seed = Hash64Value(constant.Value, seed);
+  }
+  return seed;
+}
+
+// Our GLSL targets OpenGL, which has no push_constant layout. Shaders instead declare their push
+// constants as the uniform block at this binding, which RenderDevice::PushConstants fills without a
+// buffer of the caller's. Blocks declared with layout(push_constant) in SPIRV built elsewhere are
+// moved to it when the backends translate them.
+constexpr std::uint32_t PushConstantBinding = 15;
+
+// Sections declared with variants(...) expand into one shader per combination of features. Each is
+// named after the features it enables, sorted, e.g. quadPixel[FOG,TEXTURED]. The combination with
+// nothing enabled keeps the plain name, so callers that don't care about variants are unaffected.
+inline std::string GetVariantName(const std::string& name, std::vector<std::string> features)
+{
+  if (features.empty())
+    return name;
+
+  std::sort(features.begin(), features.end());
+
+  std::string variantName = name + "[";
+  for (std::size_t i = 0; i < features.size(); i++)
+    variantName += (i ? "," : "") + features[i];
+  return variantName + "]";
+}
+
 // Shaders no longer exist as objects in the system. Now, the API that the
 // user has access to is SPIRV, which is generated entirely separately from the 
 // Renderer, via a ShaderCompiler. Render objects accept ShaderSPIRV in their
@@ -33,6 +92,23 @@ struct ShaderSPIRV
   ShaderStage Stage;
   std::string Name;
   std::vector<uint32_t> SPIRV;
+
+  // Shaders loaded from a ShaderPack reference the words directly in the pack's mapping instead of
+  // copying them into SPIRV. Backing keeps that mapping alive while the shader is in use.
+  std::span<const uint32_t> Mapped;
+  std::shared_ptr<const void> Backing;
+
+  // Filled in by the compiler, the cache and packs. Shared since shaders are copied around freely.
+  std::shared_ptr<const ShaderReflection> Reflection;
+
+  // Consumers should always read the code through here, never through SPIRV directly.
+  std::span<const uint32_t> GetCode() const
+  {
+    return Mapped.empty() ? std::span<const uint32_t>(SPIRV) : Mapped;
+  }
+
+  // Identifies the code itself, e.g. to find every pipeline built from a shader.
+  std::uint64_t GetCodeHash() const { return Hash64(GetCode().data(), GetCode().size_bytes()); }
 };
 
 }
\ No newline at end of file
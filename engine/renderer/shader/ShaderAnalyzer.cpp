@@ -0,0 +1,267 @@
+#include "ShaderAnalyzer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+
+namespace Vision
+{
+
+// SPIRV opcodes and storage classes from the spec. Ranges are contiguous in the spec's numbering.
+constexpr std::size_t headerWords = 5;
+constexpr uint32_t opLine = 8, opExtInst = 12, opTypeBool = 20, opTypeInt = 21, opTypeFloat = 22,
+                   opTypeVector = 23, opTypeMatrix = 24, opTypeArray = 28, opTypeStruct = 30,
+                   opTypePointer = 32, opConstant = 43, opFunction = 54, opFunctionParameter = 55,
+                   opFunctionEnd = 56, opFunctionCall = 57, opVariable = 59, opLoad = 61,
+                   opStore = 62, opCopyMemory = 63, opCopyMemorySized = 64, opAccessChain = 65,
+                   opPtrAccessChain = 67, opTranspose = 84, opImageSampleFirst = 87,
+                   opImageSampleLast = 97, opImageRead = 98, opImageWrite = 99,
+                   opConvertFirst = 109, opConvertLast = 124, opMathFirst = 126, opMathLast = 152,
+                   opRelationalFirst = 154, opRelationalLast = 191, opBitFirst = 194,
+                   opBitLast = 205, opDerivativeFirst = 207, opDerivativeLast = 215,
+                   opEmitVertex = 218, opEndStreamPrimitive = 221, opControlBarrier = 224,
+                   opMemoryBarrier = 225, opAtomicFirst = 227, opAtomicStore = 228,
+                   opAtomicLast = 242, opPhi = 245, opLoopMerge = 246, opSelectionMerge = 247,
+                   opLabel = 248, opBranch = 249, opBranchConditional = 250, opSwitch = 251,
+                   opKill = 252, opUnreachable = 255, opSparseSampleFirst = 305,
+                   opSparseSampleLast = 315, opNoLine = 317, opTerminateInvocation = 4416,
+                   opDemoteToHelperInvocation = 5380;
+constexpr uint32_t storageClassPrivate = 6, storageClassFunction = 7;
+constexpr std::size_t noBlock = ~std::size_t(0);
+
+static bool InRange(uint32_t opcode, uint32_t first, uint32_t last)
+{
+  return opcode >= first && opcode <= last;
+}
+
+// Inside a function, almost every instruction is <opcode> <result type> <result> <operands...>.
+// These are the exceptions we can meet there.
+static bool HasResult(uint32_t opcode)
+{
+  switch (opcode)
+  {
+    case opLine:
+    case opStore:
+    case opCopyMemory:
+    case opCopyMemorySized:
+    case opImageWrite:
+    case opControlBarrier:
+    case opMemoryBarrier:
+    case opAtomicStore:
+    case opLoopMerge:
+    case opSelectionMerge:
+    case opLabel:
+    case opNoLine:
+    case opTerminateInvocation:
+    case opDemoteToHelperInvocation: return false;
+    default:
+      return !InRange(opcode, opEmitVertex, opEndStreamPrimitive) &&
+             !InRange(opcode, opBranch, opUnreachable);
+  }
+}
+
+std::vector<std::pair<std::string, std::size_t>> ShaderCost::GetMetrics() const
+{
+  return {{"instructions", Instructions},     {"arithmetic", Arithmetic},
+          {"memory", Memory},                 {"controlFlow", ControlFlow},
+          {"textureSamples", TextureSamples}, {"loops", Loops},
+          {"branches", Branches},             {"liveComponents", LiveComponents},
+          {"localComponents", LocalComponents}};
+}
+
+ShaderCost AnalyzeShader(const ShaderSPIRV& shader)
+{
+  ShaderCost cost;
+  std::span<const uint32_t> spirv = shader.GetCode();
+  if (spirv.size() < headerWords)
+    return cost;
+
+  // Step 1) Split the module into instructions, recording type sizes and which block each function
+  // body instruction belongs to.
+  uint32_t bound = spirv[3];
+  std::vector<std::size_t> typeComponents(bound, 0), pointees(bound, 0), values(bound, 0);
+  std::vector<uint32_t> constants(bound, 1);
+  std::vector<std::size_t> definedIn(bound, noBlock);
+
+  struct Instruction
+  {
+    uint32_t Opcode;
+    std::span<const uint32_t> Words;
+  };
+  std::vector<std::vector<Instruction>> blocks;
+  bool inBlock = false;
+
+  auto component = [&](uint32_t id) { return id < bound ? typeComponents[id] : 0; };
+
+  for (std::size_t i = headerWords; i < spirv.size();)
+  {
+    uint32_t opcode = spirv[i] & 0xffff;
+    uint32_t wordCount = spirv[i] >> 16;
+    if (wordCount == 0 || i + wordCount > spirv.size())
+      return cost; // malformed
+    std::span<const uint32_t> words = spirv.subspan(i, wordCount);
+    i += wordCount;
+
+    // types declare their result in word 1, the ones we size have at least 4 words
+    uint32_t result = wordCount > 1 ? words[1] : bound;
+    if (InRange(opcode, opTypeBool, opTypePointer) &&
+        (result >= bound || (opcode > opTypeFloat && wordCount < 4)))
+      continue;
+
+    switch (opcode)
+    {
+      case opTypeBool:
+      case opTypeInt:
+      case opTypeFloat: typeComponents[result] = 1; break;
+      case opTypeVector:
+      case opTypeMatrix: typeComponents[result] = component(words[2]) * words[3]; break;
+      case opTypeArray:
+        typeComponents[result] =
+            component(words[2]) * (words[3] < bound ? constants[words[3]] : 1);
+        break;
+      case opTypeStruct:
+        for (std::size_t member = 2; member < wordCount; member++)
+          typeComponents[result] += component(words[member]);
+        break;
+      case opTypePointer:
+        pointees[result] = component(words[3]);
+        break;
+      case opConstant:
+        if (wordCount > 3 && words[2] < bound)
+          constants[words[2]] = words[3];
+        break;
+      case opVariable:
+        if (wordCount > 3 && words[1] < bound &&
+            (words[3] == storageClassFunction || words[3] == storageClassPrivate))
+          cost.LocalComponents += pointees[words[1]];
+        break;
+      case opFunction:
+      case opFunctionEnd: inBlock = false; break;
+      case opLabel:
+        blocks.emplace_back();
+        inBlock = true;
+        break;
+      default: break;
+    }
+
+    if (!inBlock || opcode == opLabel || opcode == opVariable)
+      continue;
+
+    blocks.back().push_back({opcode, words});
+    if (HasResult(opcode) && wordCount > 2 && words[2] < bound)
+    {
+      values[words[2]] = component(words[1]);
+      definedIn[words[2]] = blocks.size() - 1;
+    }
+  }
+
+  // Step 2) Count instructions by category, and find values used outside the block defining them
+  auto operands = [](const Instruction& instruction)
+  {
+    std::size_t first = HasResult(instruction.Opcode) ? 3 : 1;
+    return instruction.Words.subspan(std::min(first, instruction.Words.size()));
+  };
+
+  std::vector<char> usedElsewhere(bound, false);
+  for (std::size_t block = 0; block < blocks.size(); block++)
+  {
+    for (const Instruction& instruction : blocks[block])
+    {
+      uint32_t opcode = instruction.Opcode;
+      if (opcode == opLine || opcode == opNoLine || opcode == opLoopMerge ||
+          opcode == opSelectionMerge)
+      {
+        cost.Loops += (opcode == opLoopMerge);
+        continue;
+      }
+      cost.Instructions++;
+
+      if (opcode == opExtInst || opcode == opTranspose ||
+          InRange(opcode, opConvertFirst, opConvertLast) ||
+          InRange(opcode, opMathFirst, opMathLast) ||
+          InRange(opcode, opRelationalFirst, opRelationalLast) ||
+          InRange(opcode, opBitFirst, opBitLast) ||
+          InRange(opcode, opDerivativeFirst, opDerivativeLast))
+        cost.Arithmetic++;
+      else if (InRange(opcode, opImageSampleFirst, opImageSampleLast) ||
+               InRange(opcode, opSparseSampleFirst, opSparseSampleLast))
+        cost.TextureSamples++;
+      else if (InRange(opcode, opLoad, opPtrAccessChain) || opcode == opImageRead ||
+               opcode == opImageWrite || InRange(opcode, opAtomicFirst, opAtomicLast))
+        cost.Memory++;
+      else if (InRange(opcode, opBranch, opKill) || opcode == opPhi || opcode == opFunctionCall ||
+               opcode == opTerminateInvocation || opcode == opDemoteToHelperInvocation)
+        cost.ControlFlow++;
+
+      if (opcode == opBranchConditional)
+        cost.Branches++;
+      else if (opcode == opSwitch)
+        cost.Branches += 1 + (instruction.Words.size() - 3) / 2;
+
+      for (uint32_t id : operands(instruction))
+        if (id < bound && values[id] && definedIn[id] != block)
+          usedElsewhere[id] = true;
+    }
+  }
+
+  // Step 3) Walk each block, tracking the components of every value that is still needed. Words are
+  // taken as uses whenever they name a value, so the odd literal that matches an id overcounts
+  // slightly, which is fine for a proxy.
+  std::vector<std::size_t> lastUse(bound, noBlock);
+  for (std::size_t block = 0; block < blocks.size(); block++)
+  {
+    const std::vector<Instruction>& instructions = blocks[block];
+    std::vector<uint32_t> touched;
+    for (std::size_t k = 0; k < instructions.size(); k++)
+    {
+      for (uint32_t id : operands(instructions[k]))
+      {
+        if (id < bound && values[id])
+        {
+          lastUse[id] = k;
+          touched.push_back(id);
+        }
+      }
+    }
+
+    // values defined elsewhere are live on entry until their last use here
+    std::size_t live = 0;
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for (uint32_t id : touched)
+      if (definedIn[id] != block)
+        live += values[id];
+    std::size_t peak = live;
+
+    for (std::size_t k = 0; k < instructions.size(); k++)
+    {
+      const Instruction& instruction = instructions[k];
+      if (HasResult(instruction.Opcode) && instruction.Words.size() > 2)
+      {
+        uint32_t result = instruction.Words[2];
+        if (result < bound && (usedElsewhere[result] ||
+                               (lastUse[result] != noBlock && lastUse[result] > k)))
+          live += values[result];
+      }
+      peak = std::max(peak, live);
+
+      for (uint32_t id : operands(instruction))
+      {
+        if (id >= bound || !values[id] || lastUse[id] != k)
+          continue;
+
+        lastUse[id] = noBlock; // operands can repeat within an instruction
+        if (definedIn[id] != block || !usedElsewhere[id])
+          live -= std::min(live, values[id]);
+      }
+    }
+
+    cost.LiveComponents = std::max(cost.LiveComponents, peak);
+    for (uint32_t id : touched)
+      lastUse[id] = noBlock;
+  }
+
+  return cost;
+}
+
+} // namespace Vision
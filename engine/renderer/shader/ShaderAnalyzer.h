@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Shader.h"
+
+namespace Vision
+{
+
+// Static cost indicators of a shader, read straight from its SPIRV. None of these are timings, they
+// are meant to be compared against earlier builds of the same shader (see visionc --analyze), so a
+// regression shows up before anything runs on a GPU. Only instructions inside functions count.
+struct ShaderCost
+{
+  std::size_t Instructions = 0;
+  std::size_t Arithmetic = 0;     // math, comparisons, conversions and GLSL.std.450 calls
+  std::size_t Memory = 0;         // loads, stores, access chains, image reads/writes and atomics
+  std::size_t ControlFlow = 0;    // branches, switches, phis, calls and discards
+  std::size_t TextureSamples = 0; // samples, fetches and gathers
+  std::size_t Loops = 0;
+  std::size_t Branches = 0; // conditional branches plus one per switch target
+
+  // Register pressure proxies, in scalar components. LiveComponents is the most SSA values that are
+  // alive at once within a block, LocalComponents the size of every function and private variable.
+  std::size_t LiveComponents = 0;
+  std::size_t LocalComponents = 0;
+
+  // Name and value of every indicator, in declaration order. The names are what budgets refer to.
+  std::vector<std::pair<std::string, std::size_t>> GetMetrics() const;
+};
+
+ShaderCost AnalyzeShader(const ShaderSPIRV& shader);
+
+} // namespace Vision
@@ -0,0 +1,135 @@
+#include "ShaderCache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include "core/Hash.h"
+
+#include "ShaderCompiler.h"
+#include "ShaderReflector.h"
+
+namespace Vision
+{
+
+// Bump whenever the compiler setup changes in a way the key can't see (glslang target versions,
+// message flags, entry layout). Old entries are then simply never looked up again.
+constexpr std::uint32_t cacheVersion = 2;
+constexpr std::uint32_t cacheMagic = 0x56535056; // "VSPV"
+
+struct CacheEntryHeader
+{
+  std::uint32_t Magic;
+  std::uint32_t Version;
+  std::uint64_t Key;
+  std::uint64_t PayloadHash;
+  std::uint32_t WordCount;
+  std::uint32_t ReflectionSize; // serialized ShaderReflection, follows the SPIRV
+};
+
+ShaderCache::ShaderCache(const std::string& dir)
+    : directory(dir)
+{
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error)
+    std::cout << "Warning: unable to create shader cache folder " << directory << std::endl;
+}
+
+std::uint64_t ShaderCache::ComputeKey(const ShaderSource& source,
+                                      const ShaderCompileOptions& options)
+{
+  std::uint64_t key = Hash64Value(cacheVersion, HashSeed);
+  key = Hash64Value(source.Stage, key);
+  key = Hash64Value(options.GenerateDebugInfo, key);
+  key = Hash64Value(options.StripDebugInfo, key);
+  return Hash64(source.Source, key);
+}
+
+std::string ShaderCache::GetEntryPath(std::uint64_t key) const
+{
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.spv", static_cast<unsigned long long>(key));
+  return directory + "/" + name;
+}
+
+bool ShaderCache::Load(std::uint64_t key, ShaderSPIRV& shader) const
+{
+  std::ifstream file(GetEntryPath(key), std::ios::binary | std::ios::in);
+  if (!file.is_open())
+    return false;
+
+  CacheEntryHeader header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    return false;
+
+  if (header.Magic != cacheMagic || header.Version != cacheVersion || header.Key != key)
+    return false;
+
+  std::vector<uint32_t> data(header.WordCount);
+  std::vector<uint8_t> reflectionData(header.ReflectionSize);
+  if (!file.read(reinterpret_cast<char*>(data.data()), data.size() * 4) ||
+      !file.read(reinterpret_cast<char*>(reflectionData.data()), reflectionData.size()))
+    return false;
+
+  // A truncated or corrupted entry is treated exactly like a miss.
+  std::uint64_t payloadHash = Hash64(data.data(), data.size() * 4);
+  payloadHash = Hash64(reflectionData.data(), reflectionData.size(), payloadHash);
+  auto reflection = std::make_shared<ShaderReflection>();
+  if (payloadHash != header.PayloadHash ||
+      !reflection->Deserialize(reflectionData.data(), reflectionData.size()))
+    return false;
+
+  shader.SPIRV = std::move(data);
+  shader.Reflection = std::move(reflection);
+  return true;
+}
+
+void ShaderCache::Store(std::uint64_t key, const ShaderSPIRV& shader) const
+{
+  std::span<const uint32_t> spirv = shader.GetCode();
+  std::vector<uint8_t> reflection;
+  if (shader.Reflection)
+    reflection = shader.Reflection->Serialize();
+  else
+    reflection = ShaderReflector(shader).Reflect().Serialize();
+
+  CacheEntryHeader header;
+  header.Magic = cacheMagic;
+  header.Version = cacheVersion;
+  header.Key = key;
+  header.PayloadHash = Hash64(spirv.data(), spirv.size_bytes());
+  header.PayloadHash = Hash64(reflection.data(), reflection.size(), header.PayloadHash);
+  header.WordCount = static_cast<std::uint32_t>(spirv.size());
+  header.ReflectionSize = static_cast<std::uint32_t>(reflection.size());
+
+  // Write to a temporary file and move it into place so a concurrent reader (or a crash mid-write)
+  // can never observe a half written entry.
+  std::string path = GetEntryPath(key);
+  std::size_t thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+  std::string tempPath = path + "." + std::to_string(thread) + ".tmp";
+  {
+    std::ofstream stream(tempPath, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!stream.is_open())
+    {
+      std::cout << "Warning: Unable to cache shader " << path << std::endl;
+      return;
+    }
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(spirv.data()), spirv.size_bytes());
+    stream.write(reinterpret_cast<const char*>(reflection.data()), reflection.size());
+  }
+
+  std::error_code error;
+  std::filesystem::rename(tempPath, path, error);
+  if (error)
+  {
+    std::cout << "Warning: Unable to cache shader " << path << std::endl;
+    std::filesystem::remove(tempPath, error);
+  }
+}
+
+} // namespace Vision
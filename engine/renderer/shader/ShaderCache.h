@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Shader.h"
+
+namespace Vision
+{
+
+struct ShaderCompileOptions;
+
+// Content-addressed store for compiled SPIRV. Entries are keyed by everything that can influence
+// the binary: the fully expanded section source (common text included), the stage and the compiler
+// options. An edited file therefore only misses for the sections whose text actually changed, and a
+// binary built with different options can never be served.
+class ShaderCache
+{
+public:
+  ShaderCache(const std::string& directory = "cache/spirv");
+
+  static std::uint64_t ComputeKey(const ShaderSource& source, const ShaderCompileOptions& options);
+
+  // Entries hold the SPIRV together with its reflection. Load fills in both, leaving the stage and
+  // name to the caller.
+  bool Load(std::uint64_t key, ShaderSPIRV& shader) const;
+  void Store(std::uint64_t key, const ShaderSPIRV& shader) const;
+
+  const std::string& GetDirectory() const { return directory; }
+
+private:
+  std::string GetEntryPath(std::uint64_t key) const;
+
+private:
+  std::string directory;
+};
+
+} // namespace Vision
@@ -1,9 +1,13 @@
 #include "ShaderCompiler.h"
 
 #include <SDL.h>
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 
@@ -13,6 +17,13 @@
 #include <SPIRV/GlslangToSpv.h>
 #include <spirv_glsl.hpp>
 
+#include "core/Hash.h"
+#include "core/ThreadPool.h"
+
+#include "ShaderCache.h"
+#include "ShaderReflector.h"
+#include "ShaderWatcher.h"
+
 namespace Vision
 {
 
@@ -33,66 +44,212 @@ static EShLanguage ShaderStageToEShLanguage(ShaderStage stage)
   return EShLangVertex;
 }
 
+// glslang only needs to be set up once per process. Each TShader owns its own pool allocator, so
+// once this has run, sections can be compiled concurrently from any thread.
+static void InitializeGlslang()
+{
+  static std::once_flag initialized;
+  std::call_once(initialized,
+                 []()
+                 {
+                   glslang::InitializeProcess();
+                   std::atexit([]() { glslang::FinalizeProcess(); });
+                 });
+}
+
+// Every compiler shares a single pool, created the first time a file is compiled.
+static ThreadPool& GetCompilePool()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+// Every TShader we create, whether to compile or only to preprocess, must see the same environment.
+static void ConfigureShader(glslang::TShader& shader, EShLanguage language, const char** source)
+{
+  shader.setStrings(source, 1);
+  shader.setEnvInput(glslang::EShSourceGlsl, language, glslang::EShClientOpenGL, 450);
+  shader.setEnvClient(glslang::EShClientOpenGL, glslang::EShTargetOpenGL_450);
+  shader.setEnvTarget(glslang::EshTargetSpv, glslang::EShTargetSpv_1_1);
+
+  shader.setAutoMapBindings(true);
+  shader.setAutoMapLocations(true);
+  shader.setEntryPoint("main");
+}
+
+// Hashes the section after the preprocessor has run. Variants whose features don't change the code
+// of a stage end up identical here, so we only compile one of them. Returns zero on failure, in
+// which case the section is compiled on its own and reports its errors then.
+static std::uint64_t HashPreprocessed(const ShaderSource& source)
+{
+  InitializeGlslang();
+
+  EShLanguage language = ShaderStageToEShLanguage(source.Stage);
+  glslang::TShader shader(language);
+  const char* sourceStr = source.Source.c_str();
+  ConfigureShader(shader, language, &sourceStr);
+
+  std::string preprocessed;
+  glslang::TShader::ForbidIncluder includer;
+  if (!shader.preprocess(GetDefaultResources(), 410, ENoProfile, false, true, EShMsgDefault,
+                         &preprocessed, includer))
+    return 0;
+
+  return Hash64(preprocessed, Hash64Value(source.Stage, HashSeed));
+}
+
+// Removes what only debuggers care about: source text, file names, line info and the names of
+// anything that isn't a global variable or a struct. Those names are kept, since reflection and the
+// GL bind resources by them. Ids are left untouched, so nothing else needs rewriting.
+static void StripDebugInstructions(std::vector<uint32_t>& spirv)
+{
+  constexpr std::size_t headerWords = 5;
+  constexpr uint32_t opSourceContinued = 2, opSource = 3, opSourceExtension = 4, opName = 5,
+                     opMemberName = 6, opString = 7, opLine = 8, opTypeStruct = 30,
+                     opVariable = 59, opNoLine = 317, opModuleProcessed = 330;
+  constexpr uint32_t storageClassFunction = 7;
+
+  if (spirv.size() < headerWords)
+    return;
+
+  // Step 1) Find every id whose name is worth keeping
+  std::vector<char> keepName(spirv[3], false); // word 3 is the id bound
+  for (std::size_t i = headerWords; i < spirv.size();)
+  {
+    uint32_t opcode = spirv[i] & 0xffff;
+    uint32_t wordCount = spirv[i] >> 16;
+    if (wordCount == 0 || i + wordCount > spirv.size())
+      return; // malformed, leave it alone
+
+    if (opcode == opTypeStruct && spirv[i + 1] < keepName.size())
+      keepName[spirv[i + 1]] = true;
+    else if (opcode == opVariable && spirv[i + 3] != storageClassFunction &&
+             spirv[i + 2] < keepName.size())
+      keepName[spirv[i + 2]] = true;
+
+    i += wordCount;
+  }
+
+  // Step 2) Compact the module in place, skipping everything we don't need
+  std::size_t write = headerWords;
+  for (std::size_t i = headerWords; i < spirv.size();)
+  {
+    uint32_t opcode = spirv[i] & 0xffff;
+    uint32_t wordCount = spirv[i] >> 16;
+
+    bool strip = false;
+    switch (opcode)
+    {
+      case opSourceContinued:
+      case opSource:
+      case opSourceExtension:
+      case opString:
+      case opLine:
+      case opNoLine:
+      case opModuleProcessed: strip = true; break;
+      case opName:
+      case opMemberName: strip = spirv[i + 1] >= keepName.size() || !keepName[spirv[i + 1]]; break;
+      default: break;
+    }
+
+    if (!strip)
+    {
+      std::copy(spirv.begin() + i, spirv.begin() + i + wordCount, spirv.begin() + write);
+      write += wordCount;
+    }
+    i += wordCount;
+  }
+
+  spirv.resize(write);
+}
+
+ShaderCompileOptions ShaderCompileOptions::FromProfile(ShaderProfile profile)
+{
+  ShaderCompileOptions options;
+  options.GenerateDebugInfo = (profile == ShaderProfile::Debug);
+  options.StripDebugInfo = (profile != ShaderProfile::Debug);
+  return options;
+}
+
+ShaderCompiler::ShaderCompiler(const ShaderCompileOptions& compileOptions)
+    : options(compileOptions)
+{
+}
+
+ShaderCompiler::ShaderCompiler(ShaderProfile profile)
+    : options(ShaderCompileOptions::FromProfile(profile))
+{
+}
+
 ShaderSPIRV ShaderCompiler::CompileSource(const ShaderSource& shaderSource)
+{
+  std::string errors;
+  ShaderSPIRV compiled = CompileSource(shaderSource, errors);
+  if (!errors.empty())
+    std::cout << errors << std::flush;
+
+  return compiled;
+}
+
+ShaderSPIRV ShaderCompiler::CompileSource(const ShaderSource& shaderSource, std::string& errors)
 {
   std::vector<uint32_t> spirv;
   EShLanguage language = ShaderStageToEShLanguage(shaderSource.Stage);
   spv::SpvBuildLogger logger;
 
   // Configure glslang compiler
-  glslang::InitializeProcess();
+  InitializeGlslang();
 
   // Create and configure shader
   glslang::TShader shader(language);
 
   // Make sure this pointer is retained through the entire compilation.
   const char* sourceStr = shaderSource.Source.c_str();
-  shader.setStrings(&sourceStr, 1);
-  {
-    shader.setEnvInput(glslang::EShSourceGlsl, language, glslang::EShClientOpenGL, 450);
-    shader.setEnvClient(glslang::EShClientOpenGL, glslang::EShTargetOpenGL_450);
-    shader.setEnvTarget(glslang::EshTargetSpv, glslang::EShTargetSpv_1_1);
-
-    shader.setAutoMapBindings(true);
-    shader.setAutoMapLocations(true);
-  }
-
-  shader.setEntryPoint("main");
+  ConfigureShader(shader, language, &sourceStr);
 
   // Parse the shader
+  EShMessages debugMessages = options.GenerateDebugInfo ? EShMsgDebugInfo : EShMsgDefault;
   if (!shader.parse(GetDefaultResources(), 410, true,
-                    static_cast<EShMessages>(EShMsgDefault | EShMsgDebugInfo | EShMsgSpvRules)))
+                    static_cast<EShMessages>(EShMsgDefault | debugMessages | EShMsgSpvRules)))
   {
-    std::cout << "Failed to compile shader: " << shaderSource.Name << std::endl;
-    std::cout << shader.getInfoLog() << std::endl;
-    std::cout << shader.getInfoDebugLog() << std::endl;
+    std::ostringstream log;
+    log << "Failed to compile shader: " << shaderSource.Name << "\n";
+    log << shader.getInfoLog() << "\n";
+    log << shader.getInfoDebugLog() << "\n";
+    errors = log.str();
     return {};
   }
 
-  // TODO: Generate based on Vision configuration.
-  glslang::SpvOptions options;
-  options.disableOptimizer = false;
-  options.generateDebugInfo = true;
-  options.optimizeSize = true;
+  // glslang is built without SPIRV-Tools (ENABLE_OPT), so there is no optimizer to configure
+  glslang::SpvOptions spvOptions;
+  spvOptions.generateDebugInfo = options.GenerateDebugInfo;
+  spvOptions.stripDebugInfo = options.StripDebugInfo;
 
   // Each program only has one shader
   glslang::TProgram program;
   program.addShader(&shader);
 
-  if (!program.link(
-          static_cast<EShMessages>(EShMsgDefault | EShMsgDebugInfo | EShMsgVulkanRules)) ||
+  if (!program.link(static_cast<EShMessages>(EShMsgDefault | debugMessages | EShMsgVulkanRules)) ||
       !program.mapIO())
   {
-    std::cout << "Failed to link program:" << std::endl;
-    std::cout << program.getInfoLog() << std::endl;
+    std::ostringstream log;
+    log << "Failed to link program:\n";
+    log << program.getInfoLog() << "\n";
+    errors = log.str();
     return {};
   }
 
   // Finalize and Compile
-  glslang::GlslangToSpv(*shader.getIntermediate(), spirv, &logger, &options);
-  glslang::FinalizeProcess();
+  glslang::GlslangToSpv(*shader.getIntermediate(), spirv, &logger, &spvOptions);
 
-  return {shaderSource.Stage, shaderSource.Name, std::move(spirv)};
+  // glslang only strips through SPIRV-Tools, which we build without, so we do it ourselves.
+  if (options.StripDebugInfo)
+    StripDebugInstructions(spirv);
+
+  // Reflect while we're here, so nothing downstream has to parse the SPIRV again.
+  ShaderSPIRV compiled = {shaderSource.Stage, shaderSource.Name, std::move(spirv)};
+  compiled.Reflection = std::make_shared<ShaderReflection>(ShaderReflector(compiled).Reflect());
+  return compiled;
 }
 
 std::vector<ShaderSPIRV> ShaderCompiler::CompileFile(const std::string& filePath, bool canCache)
@@ -102,122 +259,173 @@ std::vector<ShaderSPIRV> ShaderCompiler::CompileFile(const std::string& filePath
   return shaderSPIRVs;
 }
 
-static std::string ShaderStageToSuffix(ShaderStage stage)
+void ShaderCompiler::CompileFile(const std::string& filePath, std::vector<ShaderSPIRV>& destination,
+                                 bool canCache)
 {
-  switch (stage)
-  {
-    case ShaderStage::Vertex: return "vert";
-    case ShaderStage::Pixel: return "pixel";
-    case ShaderStage::Geometry: return "geometry";
-    case ShaderStage::Compute: return "comp";
-    case ShaderStage::Domain: return "domain";
-    case ShaderStage::Hull: return "hull";
-  }
-
-  throw new std::runtime_error("Illegal shader stage to convert to file suffix!");
+  CompileFiles({filePath}, destination, canCache);
 }
 
-static ShaderStage SuffixToShaderStage(std::string suffix)
-{
-  if (suffix == "vert")
-    return ShaderStage::Vertex;
-  if (suffix == "pixel")
-    return ShaderStage::Pixel;
-  if (suffix == "geometry")
-    return ShaderStage::Geometry;
-  if (suffix == "comp")
-    return ShaderStage::Compute;
-  if (suffix == "domain")
-    return ShaderStage::Domain;
-  if (suffix == "hull")
-    return ShaderStage::Hull;
-
-  throw new std::runtime_error("Unknown shader stage file extension!");
-}
-
-void ShaderCompiler::CompileFile(const std::string& filePath, std::vector<ShaderSPIRV>& destination,
-                                 bool canCache)
+void ShaderCompiler::CompileFiles(const std::vector<std::string>& filePaths,
+                                  std::vector<ShaderSPIRV>& destination, bool canCache,
+                                  std::vector<ShaderCompileReport>* reports)
 {
-  SDL_assert(std::filesystem::exists(filePath));
+  struct FileJob
+  {
+    std::vector<ShaderSource> Sources;
+    std::vector<ShaderSPIRV> Compiled;
+    std::vector<std::uint64_t> Keys;
+    std::vector<float> Milliseconds;
+    std::vector<char> Cached; // not vector<bool>, jobs write neighbouring slots concurrently
+    std::vector<char> Deduplicated;
+    std::vector<std::uint64_t> PreprocessedHashes;
+    std::vector<std::string> Errors; // printed after the pool is done, in section order
+  };
+  std::vector<FileJob> files(filePaths.size());
+
+  // Step 1) Parse every file. Parsing is cheap next to glslang, and we always need the expanded
+  // source anyway since it is what the cache is keyed on. Because includes are expanded, editing a
+  // header only misses for the sections that actually include it.
+  ShaderParser parser; // shared, so headers included by several files are only read once
+  for (std::size_t i = 0; i < filePaths.size(); i++)
+  {
+    SDL_assert(std::filesystem::exists(filePaths[i]));
+
+    FileJob& job = files[i];
+    job.Sources = parser.ParseFile(filePaths[i]);
+    job.Compiled.resize(job.Sources.size());
+    job.Keys.resize(job.Sources.size());
+    job.Milliseconds.resize(job.Sources.size());
+    job.Cached.resize(job.Sources.size());
+    job.Deduplicated.resize(job.Sources.size());
+    job.PreprocessedHashes.resize(job.Sources.size());
+    job.Errors.resize(job.Sources.size());
+  }
 
-  // Each file that we try to compile gets a folder in the cache that holds all spirv files.
-  const std::string cacheFolder = "cache";
-  std::string cachePath = cacheFolder + "/" + filePath;
+  // Step 2) Look up every section in the cache on the pool. Each job writes into its own slot, so
+  // the output order never depends on scheduling. Misses are hashed after preprocessing instead.
+  std::unique_ptr<ShaderCache> cache;
+  if (canCache)
+    cache = std::make_unique<ShaderCache>();
 
-  // If the cache path exists, we'll go ahead and load from it.
-  if (canCache && std::filesystem::exists(cachePath) && std::filesystem::is_directory(cachePath))
+  // The pool is shared with other callers, so only this call's jobs are waited on
+  ThreadPool& pool = GetCompilePool();
+  std::vector<std::future<void>> jobs;
+  for (FileJob& job : files)
   {
-    auto cacheTime = std::filesystem::last_write_time(cachePath);
-    auto updateTime = std::filesystem::last_write_time(filePath);
-
-    if (cacheTime > updateTime)
+    for (std::size_t section = 0; section < job.Sources.size(); section++)
     {
-      for (auto& entry : std::filesystem::directory_iterator(cachePath))
-      {
-        // Each file is a ShaderSPIRV.
-        std::ifstream file(entry.path(), std::ios::binary | std::ios::in);
+      jobs.push_back(pool.Submit(
+          [this, &job, &cache, section]()
+          {
+            auto start = std::chrono::steady_clock::now();
+            const ShaderSource& source = job.Sources[section];
+            ShaderSPIRV& compiled = job.Compiled[section];
+
+            std::uint64_t key = ShaderCache::ComputeKey(source, options);
+            job.Keys[section] = key;
+
+            if (cache && cache->Load(key, compiled))
+            {
+              compiled.Stage = source.Stage;
+              compiled.Name = source.Name;
+              job.Cached[section] = true;
+            }
+            else
+              job.PreprocessedHashes[section] = HashPreprocessed(source);
+
+            auto end = std::chrono::steady_clock::now();
+            job.Milliseconds[section] =
+                std::chrono::duration<float, std::milli>(end - start).count();
+          }));
+    }
+  }
+  pool.Wait(jobs);
+  jobs.clear();
 
-        // Read the file into our vector of data.
-        std::uint32_t fileLength = std::filesystem::file_size(entry.path());
-        std::vector<uint32_t> data((fileLength + 3) / 4);
-        file.read(reinterpret_cast<char*>(data.data()), fileLength);
-        file.close();
+  // Step 3) Compile each distinct miss once. Sections that preprocess to the same text as one
+  // already scheduled (typically variants whose features don't touch that stage) share its code.
+  struct Duplicate
+  {
+    FileJob* Job;
+    std::size_t Section;
+    FileJob* OriginalJob;
+    std::size_t OriginalSection;
+  };
+  std::vector<Duplicate> duplicates;
+  std::unordered_map<std::uint64_t, std::pair<FileJob*, std::size_t>> scheduled;
+
+  for (FileJob& job : files)
+  {
+    for (std::size_t section = 0; section < job.Sources.size(); section++)
+    {
+      if (job.Cached[section])
+        continue;
 
-        // Prepare a shader spirv based on the data.
-        std::string filename = entry.path().filename().string();
+      std::uint64_t hash = job.PreprocessedHashes[section];
+      auto original = hash ? scheduled.find(hash) : scheduled.end();
+      if (original != scheduled.end())
+      {
+        duplicates.push_back({&job, section, original->second.first, original->second.second});
+        continue;
+      }
 
-        // Find the period that splits the name.
-        auto index = filename.find(".");
-        if (index == std::string::npos)
-          std::cout << "Warning: Unable to load shader in cache " << cachePath << std::endl;
+      if (hash)
+        scheduled[hash] = {&job, section};
 
-        std::string shaderName = filename.substr(0, index);
-        ShaderStage shaderStage = SuffixToShaderStage(filename.substr(index + 1));
+      jobs.push_back(pool.Submit(
+          [this, &job, &cache, section]()
+          {
+            auto start = std::chrono::steady_clock::now();
+            ShaderSPIRV& compiled = job.Compiled[section];
+            compiled = CompileSource(job.Sources[section], job.Errors[section]);
 
-        destination.push_back({shaderStage, shaderName, data});
-      }
+            // Failed compiles are never cached so the error shows up again next run.
+            if (cache && !compiled.SPIRV.empty())
+              cache->Store(job.Keys[section], compiled);
 
-      // Once we have loaded all from the cache, we are done.
-      return;
+            auto end = std::chrono::steady_clock::now();
+            job.Milliseconds[section] +=
+                std::chrono::duration<float, std::milli>(end - start).count();
+          }));
     }
   }
+  pool.Wait(jobs);
 
-  // Here we handle the case that we don't have a valid cache. Let's build one.
-  if (canCache && !std::filesystem::exists(cachePath) &&
-      !std::filesystem::create_directories(cachePath))
+  for (const Duplicate& duplicate : duplicates)
   {
-    canCache = false;
-    std::cout << "Warning: unable to create shader cache folder" << std::endl;
+    const ShaderSource& source = duplicate.Job->Sources[duplicate.Section];
+    ShaderSPIRV& compiled = duplicate.Job->Compiled[duplicate.Section];
+
+    compiled.Stage = source.Stage;
+    compiled.Name = source.Name;
+    const ShaderSPIRV& original = duplicate.OriginalJob->Compiled[duplicate.OriginalSection];
+    compiled.SPIRV = original.SPIRV;
+    compiled.Reflection = original.Reflection;
+    duplicate.Job->Deduplicated[duplicate.Section] = true;
+
+    if (cache && !compiled.SPIRV.empty())
+      cache->Store(duplicate.Job->Keys[duplicate.Section], compiled);
   }
 
-  // Compile all shaders and add them to the cache, one at a time.
-  ShaderParser parser;
-  std::vector<ShaderSource> shaderSources = parser.ParseFile(filePath);
-  for (auto& source : shaderSources)
+  // Step 4) Gather the results in file order.
+  for (std::size_t i = 0; i < files.size(); i++)
   {
-    // We can compile our shader and add it to the destination.
-    ShaderSPIRV compiled = CompileSource(source);
-    destination.push_back(compiled);
-
-    if (!canCache)
-      continue;
+    FileJob& job = files[i];
+    if (watcher)
+      watcher->Track(filePaths[i], job.Sources, job.Keys, job.Compiled);
 
-    // To generate the path, add the cache directory, and a suffix to represent the type.
-    std::string fileName =
-        cachePath + "/" + compiled.Name + "." + ShaderStageToSuffix(compiled.Stage);
-    std::ofstream stream(fileName, std::ios::binary | std::ios::out);
-
-    // Make sure that we can write to this file
-    if (!stream.is_open())
+    for (std::size_t section = 0; section < job.Compiled.size(); section++)
     {
-      std::cout << "Warning: Unable to cache shader " << fileName << std::endl;
-      continue;
+      if (!job.Errors[section].empty())
+        std::cout << job.Errors[section] << std::flush;
+
+      ShaderSPIRV& compiled = job.Compiled[section];
+      if (reports)
+        reports->push_back({filePaths[i], compiled.Name, compiled.Stage, job.Keys[section],
+                            compiled.GetCode().size_bytes(), job.Milliseconds[section],
+                            job.Cached[section] != 0, job.Deduplicated[section] != 0});
+      destination.push_back(std::move(compiled));
     }
-
-    // Clear and write to the directory
-    stream.clear();
-    stream.write(reinterpret_cast<char*>(compiled.SPIRV.data()), compiled.SPIRV.size() * 4);
-    stream.close();
   }
 }
 
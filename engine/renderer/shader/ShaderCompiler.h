@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -10,16 +11,73 @@
 namespace Vision
 {
 
+class ShaderWatcher;
+
+// Preset combinations of ShaderCompileOptions.
+enum class ShaderProfile
+{
+  Debug,   // full debug info and no optimization, for graphics debuggers
+  Release  // debug instructions and names that nothing looks up are stripped
+};
+
+// Options forwarded to glslang's SPIRV backend. These are part of the cache key, so changing any of
+// them invalidates every cached binary built without them.
+struct ShaderCompileOptions
+{
+  bool GenerateDebugInfo = true;
+  bool StripDebugInfo = false;
+
+  static ShaderCompileOptions FromProfile(ShaderProfile profile);
+};
+
+// Per-section report produced by the multi-file compile path.
+struct ShaderCompileReport
+{
+  std::string File;
+  std::string Name;
+  ShaderStage Stage;
+  std::uint64_t SourceKey = 0; // see ShaderCache::ComputeKey
+  std::size_t Bytes = 0;        // of the SPIRV
+  float Milliseconds = 0.0f;
+  bool Cached = false;
+  bool Deduplicated = false; // shares the code of an identical section compiled in the same batch
+};
+
 class ShaderCompiler
 {
 public:
+  ShaderCompiler(const ShaderCompileOptions& options = {});
+  ShaderCompiler(ShaderProfile profile);
+
   ShaderSPIRV CompileSource(const ShaderSource& shaderSource);
 
+  // Same as above, but writes compile and link errors into errors instead of printing them, so
+  // callers on worker threads can print them later without interleaving.
+  ShaderSPIRV CompileSource(const ShaderSource& shaderSource, std::string& errors);
+
   std::vector<ShaderSPIRV> CompileFile(const std::string& filePath, bool canCache = false);
   void CompileFile(const std::string& filePath, std::vector<ShaderSPIRV>& destination,
                    bool canCache = false);
   std::unordered_map<std::string, ShaderSPIRV> CompileFileToMap(const std::string& filePath,
                                                                 bool canCache = false);
+
+  // Compiles every section of every file on the shared worker pool. The output is ordered by file,
+  // then by section, exactly as the serial path would produce it, regardless of which compile
+  // finishes first. When caching, each section is looked up by the hash of its expanded source.
+  // Misses that preprocess to the same text, such as variants that don't affect a stage, are only
+  // compiled once.
+  void CompileFiles(const std::vector<std::string>& filePaths,
+                    std::vector<ShaderSPIRV>& destination, bool canCache = false,
+                    std::vector<ShaderCompileReport>* reports = nullptr);
+
+  const ShaderCompileOptions& GetOptions() const { return options; }
+
+  // Every file compiled from now on is watched for edits (see ShaderWatcher).
+  void SetWatcher(ShaderWatcher* shaderWatcher) { watcher = shaderWatcher; }
+
+private:
+  ShaderCompileOptions options;
+  ShaderWatcher* watcher = nullptr;
 };
 
-} // namespace Vision
\ No newline at end of file
+} // namespace Vision
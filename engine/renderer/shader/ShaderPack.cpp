@@ -0,0 +1,276 @@
+#include "ShaderPack.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+#include "core/Hash.h"
+#include "core/MappedFile.h"
+
+#include "ShaderReflector.h"
+
+namespace Vision
+{
+
+constexpr std::uint32_t packMagic = 0x4b415056; // "VPAK"
+constexpr std::uint32_t packVersion = 2;
+constexpr std::size_t packAlignment = 16;
+
+struct PackHeader
+{
+  std::uint32_t Magic;
+  std::uint32_t Version;
+  std::uint32_t EntryCount;
+  std::uint32_t StringTableSize;
+  std::uint64_t FileSize;
+  std::uint32_t ReflectionTableSize;
+  std::uint32_t Reserved;
+};
+
+struct PackEntry
+{
+  std::uint64_t SourceKey;
+  std::uint64_t CodeHash;
+  std::uint64_t CodeOffset; // from the start of the pack
+  std::uint32_t WordCount;
+  std::uint32_t NameOffset; // into the string table
+  std::uint32_t NameLength;
+  std::uint32_t Stage;
+  std::uint32_t ReflectionOffset; // into the reflection table
+  std::uint32_t ReflectionSize;
+};
+
+static std::size_t AlignUp(std::size_t value, std::size_t alignment)
+{
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// ----- ShaderPack -----
+
+std::shared_ptr<ShaderPack> ShaderPack::Open(const std::string& filePath)
+{
+  std::shared_ptr<ShaderPack> pack(new ShaderPack());
+  pack->mapping = std::make_unique<MappedFile>(filePath);
+
+  if (!pack->mapping->IsValid() ||
+      !pack->Parse(pack->mapping->GetData(), pack->mapping->GetSize()))
+  {
+    std::cout << "Failed to load shader pack: " << filePath << std::endl;
+    return nullptr;
+  }
+
+  return pack;
+}
+
+std::shared_ptr<ShaderPack> ShaderPack::FromMemory(const void* data, std::size_t size)
+{
+  std::shared_ptr<ShaderPack> pack(new ShaderPack());
+
+  // Data embedded in the binary is referenced in place, it lives as long as the program. We only
+  // have to copy if the compiler didn't give us word alignment.
+  if (reinterpret_cast<std::uintptr_t>(data) % alignof(std::uint32_t) != 0)
+  {
+    pack->ownedData.resize((size + 3) / 4);
+    std::memcpy(pack->ownedData.data(), data, size);
+    data = pack->ownedData.data();
+  }
+
+  if (!pack->Parse(data, size))
+  {
+    std::cout << "Failed to load embedded shader pack" << std::endl;
+    return nullptr;
+  }
+
+  return pack;
+}
+
+ShaderPack::~ShaderPack() = default;
+
+bool ShaderPack::Parse(const void* data, std::size_t size)
+{
+  const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+  if (size < sizeof(PackHeader))
+    return false;
+
+  PackHeader header;
+  std::memcpy(&header, bytes, sizeof(PackHeader));
+  if (header.Magic != packMagic || header.Version != packVersion || header.FileSize != size)
+    return false;
+
+  std::size_t indexEnd = sizeof(PackHeader) + header.EntryCount * sizeof(PackEntry);
+  std::size_t stringsEnd = indexEnd + header.StringTableSize;
+  std::size_t reflectionEnd = stringsEnd + header.ReflectionTableSize;
+  if (reflectionEnd > size)
+    return false;
+
+  const char* strings = reinterpret_cast<const char*>(bytes + indexEnd);
+  const std::uint8_t* reflections = bytes + stringsEnd;
+
+  entries.reserve(header.EntryCount);
+  for (std::uint32_t i = 0; i < header.EntryCount; i++)
+  {
+    // Copied out rather than cast, embedded packs are only guaranteed word alignment.
+    PackEntry packEntry;
+    std::memcpy(&packEntry, bytes + sizeof(PackHeader) + i * sizeof(PackEntry), sizeof(PackEntry));
+
+    if (packEntry.NameOffset + packEntry.NameLength > header.StringTableSize ||
+        packEntry.ReflectionOffset + std::uint64_t(packEntry.ReflectionSize) >
+            header.ReflectionTableSize ||
+        packEntry.CodeOffset % alignof(std::uint32_t) != 0 ||
+        packEntry.CodeOffset + packEntry.WordCount * 4ull > size)
+      return false;
+
+    // Reflection is small, so it is decoded up front rather than on every GetShader.
+    auto reflection = std::make_shared<ShaderReflection>();
+    if (!reflection->Deserialize(reflections + packEntry.ReflectionOffset,
+                                 packEntry.ReflectionSize))
+      return false;
+
+    Entry entry;
+    entry.Name = std::string(strings + packEntry.NameOffset, packEntry.NameLength);
+    entry.Stage = static_cast<ShaderStage>(packEntry.Stage);
+    entry.SourceKey = packEntry.SourceKey;
+    entry.CodeHash = packEntry.CodeHash;
+    entry.Code = reinterpret_cast<const uint32_t*>(bytes + packEntry.CodeOffset);
+    entry.WordCount = packEntry.WordCount;
+    entry.Reflection = std::move(reflection);
+    entries.push_back(std::move(entry));
+  }
+
+  return true;
+}
+
+ShaderSPIRV ShaderPack::GetShader(std::size_t index) const
+{
+  const Entry& entry = entries[index];
+
+  ShaderSPIRV shader;
+  shader.Stage = entry.Stage;
+  shader.Name = entry.Name;
+  shader.Mapped = std::span<const uint32_t>(entry.Code, entry.WordCount);
+  shader.Backing = shared_from_this();
+  shader.Reflection = entry.Reflection;
+  return shader;
+}
+
+std::vector<ShaderSPIRV> ShaderPack::GetShaders() const
+{
+  std::vector<ShaderSPIRV> shaders;
+  shaders.reserve(entries.size());
+
+  for (std::size_t i = 0; i < entries.size(); i++)
+    shaders.push_back(GetShader(i));
+
+  return shaders;
+}
+
+bool ShaderPack::FindShader(const std::string& name, ShaderStage stage,
+                            ShaderSPIRV& destination) const
+{
+  for (std::size_t i = 0; i < entries.size(); i++)
+  {
+    if (entries[i].Stage == stage && entries[i].Name == name)
+    {
+      destination = GetShader(i);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// ----- ShaderPackWriter -----
+
+void ShaderPackWriter::Add(const ShaderSPIRV& shader, std::uint64_t sourceKey)
+{
+  entries.push_back({shader, sourceKey});
+}
+
+std::vector<uint8_t> ShaderPackWriter::Serialize() const
+{
+  // Lay out the index, string and reflection tables first, so we know where the payloads begin.
+  std::string strings;
+  std::vector<uint8_t> reflections;
+  std::vector<PackEntry> index(entries.size());
+  for (std::size_t i = 0; i < entries.size(); i++)
+  {
+    const ShaderSPIRV& shader = entries[i].Shader;
+    index[i].NameOffset = static_cast<std::uint32_t>(strings.size());
+    index[i].NameLength = static_cast<std::uint32_t>(shader.Name.size());
+    strings.append(shader.Name);
+
+    std::vector<uint8_t> reflection = ShaderReflector::GetReflection(shader)->Serialize();
+    index[i].ReflectionOffset = static_cast<std::uint32_t>(reflections.size());
+    index[i].ReflectionSize = static_cast<std::uint32_t>(reflection.size());
+    reflections.insert(reflections.end(), reflection.begin(), reflection.end());
+  }
+
+  // Entries with identical code (e.g. variants that compile to the same thing) share one payload.
+  std::unordered_map<std::uint64_t, std::uint64_t> payloads;
+  std::size_t offset = sizeof(PackHeader) + index.size() * sizeof(PackEntry) + strings.size() +
+                       reflections.size();
+  for (std::size_t i = 0; i < entries.size(); i++)
+  {
+    std::span<const uint32_t> code = entries[i].Shader.GetCode();
+
+    index[i].SourceKey = entries[i].SourceKey;
+    index[i].CodeHash = Hash64(code.data(), code.size_bytes());
+    index[i].WordCount = static_cast<std::uint32_t>(code.size());
+    index[i].Stage = static_cast<std::uint32_t>(entries[i].Shader.Stage);
+
+    auto payload = payloads.find(index[i].CodeHash);
+    if (payload != payloads.end())
+    {
+      index[i].CodeOffset = payload->second;
+      continue;
+    }
+
+    offset = AlignUp(offset, packAlignment);
+    index[i].CodeOffset = offset;
+    payloads[index[i].CodeHash] = offset;
+    offset += code.size_bytes();
+  }
+
+  PackHeader header;
+  header.Magic = packMagic;
+  header.Version = packVersion;
+  header.EntryCount = static_cast<std::uint32_t>(entries.size());
+  header.StringTableSize = static_cast<std::uint32_t>(strings.size());
+  header.FileSize = offset;
+  header.ReflectionTableSize = static_cast<std::uint32_t>(reflections.size());
+  header.Reserved = 0;
+
+  // Now that everything is placed, copy it into a single zeroed buffer.
+  std::vector<uint8_t> data(offset, 0);
+  std::memcpy(data.data(), &header, sizeof(PackHeader));
+  std::memcpy(data.data() + sizeof(PackHeader), index.data(), index.size() * sizeof(PackEntry));
+  std::size_t tables = sizeof(PackHeader) + index.size() * sizeof(PackEntry);
+  std::memcpy(data.data() + tables, strings.data(), strings.size());
+  std::memcpy(data.data() + tables + strings.size(), reflections.data(), reflections.size());
+
+  for (std::size_t i = 0; i < entries.size(); i++)
+  {
+    std::span<const uint32_t> code = entries[i].Shader.GetCode();
+    std::memcpy(data.data() + index[i].CodeOffset, code.data(), code.size_bytes());
+  }
+
+  return data;
+}
+
+bool ShaderPackWriter::Write(const std::string& filePath) const
+{
+  std::vector<uint8_t> data = Serialize();
+
+  std::ofstream stream(filePath, std::ios::binary | std::ios::out | std::ios::trunc);
+  if (!stream.is_open())
+  {
+    std::cout << "Unable to write shader pack: " << filePath << std::endl;
+    return false;
+  }
+
+  stream.write(reinterpret_cast<const char*>(data.data()), data.size());
+  return stream.good();
+}
+
+} // namespace Vision
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Shader.h"
+
+namespace Vision
+{
+
+class MappedFile;
+
+// A shader pack bundles any number of compiled shaders into a single file so startup costs one
+// open and one mapping instead of a file per shader. The layout is:
+//
+//   PackHeader
+//   PackEntry[EntryCount]    index of name, stage, source key and code hash
+//   char[]                   string table holding every name
+//   uint8_t[]                reflection table, a serialized ShaderReflection per entry
+//   uint32_t[]               SPIRV payloads, each aligned to PackAlignment bytes
+//
+// Entries whose code is identical point at the same payload.
+// Shaders returned from a pack reference their payload directly inside the mapping, and share the
+// pack's copy of their reflection.
+class ShaderPack : public std::enable_shared_from_this<ShaderPack>
+{
+public:
+  static std::shared_ptr<ShaderPack> Open(const std::string& filePath);
+
+  // The pack isn't copied: it and every shader taken from it point into the data, and those
+  // shaders can outlive the returned handle. Only pass data that lives as long as the program, like
+  // the embedded BuiltinShaderPack array.
+  static std::shared_ptr<ShaderPack> FromMemory(const void* data, std::size_t size);
+  ~ShaderPack();
+
+  std::size_t GetNumShaders() const { return entries.size(); }
+  ShaderSPIRV GetShader(std::size_t index) const;
+  std::vector<ShaderSPIRV> GetShaders() const;
+
+  // Returns false and leaves the destination untouched if the pack holds no such shader.
+  bool FindShader(const std::string& name, ShaderStage stage, ShaderSPIRV& destination) const;
+
+  std::uint64_t GetSourceKey(std::size_t index) const { return entries[index].SourceKey; }
+  std::uint64_t GetCodeHash(std::size_t index) const { return entries[index].CodeHash; }
+
+private:
+  ShaderPack() = default;
+  bool Parse(const void* data, std::size_t size);
+
+private:
+  struct Entry
+  {
+    std::string Name;
+    ShaderStage Stage;
+    std::uint64_t SourceKey;
+    std::uint64_t CodeHash;
+    const uint32_t* Code;
+    std::size_t WordCount;
+    std::shared_ptr<const ShaderReflection> Reflection;
+  };
+  std::vector<Entry> entries;
+
+  // Exactly one of these owns the bytes that the entries point into.
+  std::unique_ptr<MappedFile> mapping;
+  std::vector<uint32_t> ownedData;
+};
+
+// Builds a pack file. The source key is the ShaderCache key of the section the code was compiled
+// from, which lets tooling tell whether an entry is still current without recompiling it.
+class ShaderPackWriter
+{
+public:
+  void Add(const ShaderSPIRV& shader, std::uint64_t sourceKey = 0);
+
+  std::vector<uint8_t> Serialize() const;
+  bool Write(const std::string& filePath) const;
+
+private:
+  struct Entry
+  {
+    ShaderSPIRV Shader;
+    std::uint64_t SourceKey;
+  };
+  std::vector<Entry> entries;
+};
+
+} // namespace Vision
@@ -1,13 +1,17 @@
 #include "ShaderParser.h"
 
+#include <algorithm>
+#include <cctype>
 #include <iostream>
 #include <SDL.h>
 
+#include "core/MappedFile.h"
+
 namespace Vision
 {
 
 // Helper Function
-static ShaderStage ShaderStageFromString(const std::string &type)
+static ShaderStage ShaderStageFromString(std::string_view type)
 {
   if (type == "vertex")
     return ShaderStage::Vertex;
@@ -26,115 +30,308 @@ static ShaderStage ShaderStageFromString(const std::string &type)
   return ShaderStage::Vertex;
 }
 
+static void SplitList(std::string_view list, std::vector<std::string_view>& destination)
+{
+  std::size_t start = 0;
+  while (start <= list.size())
+  {
+    std::size_t end = std::min(list.find(',', start), list.size());
+    if (end > start)
+      destination.push_back(list.substr(start, end - start));
+    start = end + 1;
+  }
+}
+
+static bool IsParameterCharacter(char c)
+{
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == ',' || c == '=' ||
+         c == '.' || c == '-';
+}
+
 std::vector<ShaderSource> ShaderParser::ParseFile(const std::string& filePath)
 {
-  // Step 1) Load the file from disk
-  SDL_RWops *file = SDL_RWFromFile(filePath.c_str(), "r+");
-  if (!file)
+  // Step 1) Map the file, the whole parse works on views into it
+  MappedFile file(filePath);
+  if (!file.IsValid())
   {
-    std::cout << "Failed to open shader file: " << SDL_GetError() << std::endl;
+    std::cout << "Failed to open shader file: " << filePath << std::endl;
     return {};
   }
 
-  size_t size = SDL_RWsize(file);
-  std::string source(size, ' ');
-  SDL_RWread(file, &source[0], size);
-  SDL_RWclose(file);
+  std::string_view source(static_cast<const char*>(file.GetData()), file.GetSize());
+  return ParseSource(source, filePath);
+}
 
-  // Step 2) Iterate over the sections of the string, breaking apart into ShaderSources.
-  const char *sectionToken = "#section ";
-  const size_t sectionTokenLength = std::strlen(sectionToken);
-  std::vector<ShaderSource> sources;
-  std::string commonText; // appends common source as we iterate
+std::vector<ShaderSource> ShaderParser::ParseSource(std::string_view source,
+                                                    const std::string& filePath)
+{
+  struct Section
+  {
+    ShaderStage Stage;
+    std::string_view Name;
+    std::string_view Text;
+    bool Common;
+    std::vector<std::string_view> Defines;
+    std::vector<std::string_view> Variants;
+  };
+  std::vector<Section> sections;
+  std::size_t commonSize = 0;
+
+  // Step 2) Iterate over the sections of the string, recording where each one lives.
+  constexpr std::string_view sectionToken = "#section ";
 
   std::size_t pos = source.find(sectionToken, 0);
-  while (pos != std::string::npos)
+  while (pos != std::string_view::npos)
   {
     // Step 3) Extract the section decorations
-    size_t eol = source.find_first_of("\r\n", pos);
-    SDL_assert(eol != std::string::npos); // ensure that we have another line
-    size_t begin = pos + sectionTokenLength; // start of decorations
-    std::string decorations = source.substr(begin, eol - begin); // substr to get type value
+    std::size_t eol = source.find_first_of("\r\n", pos);
+    SDL_assert(eol != std::string_view::npos); // ensure that we have another line
+    std::size_t begin = pos + sectionToken.size(); // start of decorations
+    std::string_view decorations = source.substr(begin, eol - begin);
 
     // Step 4) Parse the section decorations
-    std::string name;
-    ShaderStage stage;
-    bool common = false;
+    Section section = {ShaderStage::Vertex, {}, {}, false, {}, {}};
     std::size_t startIndex = decorations.find_first_not_of(' ');
-    while (startIndex != std::string::npos) 
+    while (startIndex != std::string_view::npos)
     {
       std::size_t endIndex = decorations.find_first_of(' ', startIndex);
-      std::string decoration = (endIndex == std::string::npos) ? decorations.substr(startIndex) : decorations.substr(startIndex, endIndex - startIndex);
-      
+      std::string_view decoration = decorations.substr(startIndex, endIndex - startIndex);
+      startIndex = decorations.find_first_not_of(' ', endIndex);
+
       std::size_t paramIndex = decoration.find_first_of('(');
-      std::string decorType = decoration.substr(0, paramIndex);
+      std::string_view decorType = decoration.substr(0, paramIndex);
 
       // Parse the parameter if one exists
-      std::string paramValue;
-      if (paramIndex != std::string::npos)
-      {  
-        paramIndex++; // start after the opening parenthesis
-        char paramChar = decoration[paramIndex];
-        while (std::isalpha(paramChar))
-        {
-          paramValue.push_back(paramChar);
-          paramChar = decoration[++paramIndex];
-        }
+      std::string_view paramValue;
+      if (paramIndex != std::string_view::npos)
+      {
+        std::size_t paramStart = ++paramIndex; // start after the opening parenthesis
+        while (paramIndex < decoration.size() && IsParameterCharacter(decoration[paramIndex]))
+          paramIndex++;
 
-        if (paramChar != ')')
+        if (paramIndex >= decoration.size() || decoration[paramIndex] != ')')
         {
           std::cout << "ShaderParser Error: " << filePath << std::endl;
-          std::cout << "Decoration parameters may only contain letters and must end with ')'!" << std::endl;
-          startIndex = decorations.find_first_not_of(' ', endIndex);
+          std::cout << "Decoration parameters may only contain letters, digits and _,=.- and must "
+                       "end with ')'!"
+                    << std::endl;
           continue;
         }
+
+        paramValue = decoration.substr(paramStart, paramIndex - paramStart);
       }
 
       // Handle each parameter type
-      if (decorType == "common") 
-        common = true;
+      if (decorType == "common")
+        section.Common = true;
       else if (decorType == "name")
-        name = paramValue;
+        section.Name = paramValue;
       else if (decorType == "type")
-        stage = ShaderStageFromString(paramValue);
+        section.Stage = ShaderStageFromString(paramValue);
+      else if (decorType == "define")
+        SplitList(paramValue, section.Defines);
+      else if (decorType == "variants")
+        SplitList(paramValue, section.Variants);
       else
       {
         std::cout << "Unknown Shader Decoration: " << decorType << std::endl;
         return {};
       }
-
-      startIndex = decorations.find_first_not_of(' ', endIndex);
     }
 
-    // Step 5) Substring to get our next section of shader code
-    size_t nextLinePos = source.find_first_not_of("\r\n", eol); // Start of shader code after shader type declaration line
-    SDL_assert(nextLinePos != std::string::npos);
+    // Step 5) Record the span of shader code up to the next section
+    std::size_t nextLinePos = source.find_first_not_of("\r\n", eol); // Start of shader code after shader type declaration line
+    SDL_assert(nextLinePos != std::string_view::npos);
     pos = source.find(sectionToken, nextLinePos); // Start of next shader type declaration line
-    std::string section = (pos == std::string::npos) ? source.substr(nextLinePos) : source.substr(nextLinePos, pos - nextLinePos);
+    section.Text = source.substr(nextLinePos, pos - nextLinePos);
+
+    // Every feature doubles the number of shaders, keep that from getting out of hand.
+    constexpr std::size_t maxVariantFeatures = 8;
+    if (section.Variants.size() > maxVariantFeatures)
+    {
+      std::cout << "ShaderParser Error: " << section.Name << " in " << filePath << " declares more "
+                << "than " << maxVariantFeatures << " variant features!" << std::endl;
+      return {};
+    }
+
+    if (section.Common)
+      commonSize += section.Text.size() + 1;
+    sections.push_back(std::move(section));
+  }
+
+  // Step 6) Build every source in one go. Common text applies to every section in the file,
+  // wherever it appears, and each piece is separated by a new line so neither side needs one.
+  std::filesystem::path directory = std::filesystem::path(filePath).parent_path();
+  std::vector<ShaderSource> sources;
+  for (std::size_t i = 0; i < sections.size(); i++)
+  {
+    if (sections[i].Common)
+      continue;
+
+    std::string combinedSource;
+    std::vector<std::string> included;
+    combinedSource.reserve(commonSize + sections[i].Text.size());
 
-    // Step 6) handle common type by adding to common buffer as well as the end of any parsed strings
-    if (common)
+    for (std::size_t j = 0; j < i; j++)
     {
-      commonText.append("\n"); // append a new line so neither original nor new need line break
-      commonText.append(section);
+      if (!sections[j].Common)
+        continue;
+
+      combinedSource.push_back('\n');
+      AppendExpanded(combinedSource, sections[j].Text, directory, included);
+    }
+
+    AppendExpanded(combinedSource, sections[i].Text, directory, included);
+
+    for (std::size_t j = i + 1; j < sections.size(); j++)
+    {
+      if (!sections[j].Common)
+        continue;
+
+      combinedSource.push_back('\n');
+      AppendExpanded(combinedSource, sections[j].Text, directory, included);
+    }
+
+    const Section& section = sections[i];
+    if (section.Defines.empty() && section.Variants.empty())
+    {
+      sources.push_back({section.Stage, std::string(section.Name), std::move(combinedSource),
+                         std::move(included)});
+      continue;
+    }
 
-      for (auto& source : sources)
+    // Every combination of features is its own source, with the enabled ones defined.
+    for (std::size_t mask = 0; mask < (std::size_t(1) << section.Variants.size()); mask++)
+    {
+      std::vector<std::string_view> defines = section.Defines;
+      std::vector<std::string> enabled;
+      for (std::size_t feature = 0; feature < section.Variants.size(); feature++)
       {
-        source.Source.append("\n"); // append a new line so neither original nor new need line break
-        source.Source.append(section);
+        if (!(mask & (std::size_t(1) << feature)))
+          continue;
+
+        defines.push_back(section.Variants[feature]);
+        enabled.emplace_back(section.Variants[feature]);
       }
 
-      continue; // don't create a new section
+      sources.push_back({section.Stage, GetVariantName(std::string(section.Name), enabled),
+                         InsertDefines(combinedSource, defines), included});
     }
-
-    // Step 7) otherwise, create a new shader stage
-    std::string combinedSource = commonText;
-    combinedSource.append(section);
-    sources.push_back({ stage, name, combinedSource });
   }
 
-  // Step 8) Return our parsed shaders
+  // Step 7) Return our parsed shaders
   return sources;
 }
 
-}
\ No newline at end of file
+void ShaderParser::AppendExpanded(std::string& destination, std::string_view text,
+                                  const std::filesystem::path& directory,
+                                  std::vector<std::string>& included)
+{
+  constexpr std::string_view includeToken = "#include";
+
+  // Most sections don't include anything
+  if (text.find(includeToken) == std::string_view::npos)
+  {
+    destination.append(text);
+    return;
+  }
+
+  std::size_t lineStart = 0;
+  while (lineStart < text.size())
+  {
+    std::size_t lineEnd = text.find('\n', lineStart);
+    lineEnd = (lineEnd == std::string_view::npos) ? text.size() : lineEnd + 1;
+    std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+    lineStart = lineEnd;
+
+    std::size_t first = line.find_first_not_of(" \t");
+    if (first == std::string_view::npos || line.compare(first, includeToken.size(), includeToken))
+    {
+      destination.append(line);
+      continue;
+    }
+
+    std::size_t open = line.find('"', first + includeToken.size());
+    std::size_t close = (open == std::string_view::npos) ? open : line.find('"', open + 1);
+    if (close == std::string_view::npos)
+    {
+      std::cout << "ShaderParser Error: malformed include: " << line << std::endl;
+      continue;
+    }
+
+    // Headers are identified by their canonical path, so the same file reached through different
+    // relative paths is still only included once.
+    std::error_code error;
+    std::filesystem::path path = directory / line.substr(open + 1, close - open - 1);
+    std::string includePath = std::filesystem::weakly_canonical(path, error).string();
+    if (error)
+      includePath = path.lexically_normal().string();
+
+    if (std::find(included.begin(), included.end(), includePath) != included.end())
+      continue;
+    included.push_back(includePath);
+
+    const std::string* contents = LoadInclude(includePath);
+    if (!contents)
+    {
+      std::cout << "ShaderParser Error: unable to include " << includePath << std::endl;
+      continue;
+    }
+
+    AppendExpanded(destination, *contents, std::filesystem::path(includePath).parent_path(),
+                   included);
+    if (!destination.empty() && destination.back() != '\n')
+      destination.push_back('\n');
+  }
+}
+
+std::string ShaderParser::InsertDefines(const std::string& source,
+                                        const std::vector<std::string_view>& defines)
+{
+  // Definitions have to come after #version, which must be the first thing in a shader.
+  std::size_t insertAt = 0;
+  std::size_t version = source.find("#version");
+  if (version != std::string::npos)
+  {
+    std::size_t eol = source.find('\n', version);
+    insertAt = (eol == std::string::npos) ? source.size() : eol + 1;
+  }
+
+  std::string block = (insertAt && source[insertAt - 1] != '\n') ? "\n" : "";
+  for (std::string_view define : defines)
+  {
+    std::size_t equals = define.find('=');
+    block += "#define ";
+    block += define.substr(0, equals);
+    block += ' ';
+    block += (equals == std::string_view::npos) ? "1" : define.substr(equals + 1);
+    block += '\n';
+  }
+
+  // Keep compile errors on the same lines they'd be reported on without the definitions.
+  std::size_t line = std::count(source.begin(), source.begin() + insertAt, '\n') + 1;
+  block += "#line " + std::to_string(line) + "\n";
+
+  std::string result;
+  result.reserve(source.size() + block.size());
+  result.append(source, 0, insertAt);
+  result.append(block);
+  result.append(source, insertAt);
+  return result;
+}
+
+const std::string* ShaderParser::LoadInclude(const std::string& filePath)
+{
+  auto cached = includeCache.find(filePath);
+  if (cached != includeCache.end())
+    return &cached->second;
+
+  MappedFile file(filePath);
+  if (!file.IsValid())
+    return nullptr;
+
+  std::string contents(static_cast<const char*>(file.GetData()), file.GetSize());
+  return &includeCache.emplace(filePath, std::move(contents)).first->second;
+}
+
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <filesystem>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "Shader.h"
@@ -12,10 +15,39 @@ namespace Vision
 // But I want support for multiple programs within a file, beyond just
 // one VS and FS. We should also support multiple compute kernels. We'll
 // do this by having #section type(vertex) name(vertex)
+//
+// Parsing is a single pass over one buffer (the file is memory mapped). Sections are recorded as
+// views into it, and each expanded source is built exactly once at the end.
+//
+// Sections may #include "file" relative to the including file. Each file is included at most once
+// per section, as if every header had #pragma once, and the included files are reported as the
+// section's Dependencies. A parser caches every header it reads, so reuse one across files.
+//
+// Besides type and name, a section may be decorated with
+//   define(A=1,B)       definitions added after the #version line of the section
+//   variants(FOG,LIT)   expands the section into every combination of the listed features, each
+//                       compiled with the enabled ones defined (see GetVariantName)
+// Decoration parameters can't contain spaces.
 class ShaderParser
 {
 public:
   std::vector<ShaderSource> ParseFile(const std::string& file);
+
+  // filePath is used for error messages and to resolve includes.
+  std::vector<ShaderSource> ParseSource(std::string_view source,
+                                        const std::string& filePath = "<memory>");
+
+private:
+  void AppendExpanded(std::string& destination, std::string_view text,
+                      const std::filesystem::path& directory,
+                      std::vector<std::string>& included);
+  const std::string* LoadInclude(const std::string& filePath);
+
+  static std::string InsertDefines(const std::string& source,
+                                   const std::vector<std::string_view>& defines);
+
+private:
+  std::unordered_map<std::string, std::string> includeCache;
 };
 
-}
\ No newline at end of file
+}
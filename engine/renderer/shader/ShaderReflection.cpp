@@ -0,0 +1,145 @@
+#include "ShaderReflection.h"
+
+#include <cstring>
+#include <span>
+
+namespace Vision
+{
+
+// The format is private to the cache and packs, which carry their own version numbers. It is just
+// every field in declaration order, with 32 bit integers and length prefixed strings.
+
+// helper functions
+static void Write(std::vector<std::uint8_t>& data, std::uint32_t value)
+{
+  std::uint8_t bytes[4];
+  std::memcpy(bytes, &value, 4);
+  data.insert(data.end(), bytes, bytes + 4);
+}
+
+static void Write(std::vector<std::uint8_t>& data, const std::string& value)
+{
+  Write(data, static_cast<std::uint32_t>(value.size()));
+  data.insert(data.end(), value.begin(), value.end());
+}
+
+static void Write(std::vector<std::uint8_t>& data,
+                  const std::vector<ShaderReflection::Resource>& resources)
+{
+  Write(data, static_cast<std::uint32_t>(resources.size()));
+  for (const ShaderReflection::Resource& resource : resources)
+  {
+    Write(data, resource.Name);
+    Write(data, resource.Binding);
+    Write(data, resource.ArraySize);
+    Write(data, resource.Size);
+  }
+}
+
+// Readers advance through the span and fail rather than read past its end.
+static bool Read(std::span<const std::uint8_t>& data, std::uint32_t& value)
+{
+  if (data.size() < 4)
+    return false;
+
+  std::memcpy(&value, data.data(), 4);
+  data = data.subspan(4);
+  return true;
+}
+
+static bool Read(std::span<const std::uint8_t>& data, std::string& value)
+{
+  std::uint32_t length;
+  if (!Read(data, length) || data.size() < length)
+    return false;
+
+  value.assign(reinterpret_cast<const char*>(data.data()), length);
+  data = data.subspan(length);
+  return true;
+}
+
+static bool Read(std::span<const std::uint8_t>& data,
+                 std::vector<ShaderReflection::Resource>& resources)
+{
+  std::uint32_t count;
+  if (!Read(data, count) || count > data.size())
+    return false;
+
+  resources.resize(count);
+  for (ShaderReflection::Resource& resource : resources)
+  {
+    if (!Read(data, resource.Name) || !Read(data, resource.Binding) ||
+        !Read(data, resource.ArraySize) || !Read(data, resource.Size))
+      return false;
+  }
+  return true;
+}
+
+std::vector<std::uint8_t> ShaderReflection::Serialize() const
+{
+  std::vector<std::uint8_t> data;
+
+  Write(data, static_cast<std::uint32_t>(VertexInputs.size()));
+  for (const VertexInput& input : VertexInputs)
+  {
+    Write(data, input.Name);
+    Write(data, input.Location);
+    Write(data, static_cast<std::uint32_t>(input.Type));
+    Write(data, input.Components);
+    Write(data, input.Columns);
+  }
+
+  Write(data, UniformBuffers);
+  Write(data, StorageBuffers);
+  Write(data, SampledImages);
+  Write(data, PushConstants);
+
+  for (std::size_t i = 0; i < 3; i++)
+  {
+    Write(data, WorkgroupSize[i]);
+    Write(data, WorkgroupSizeConstants[i]);
+  }
+
+  return data;
+}
+
+bool ShaderReflection::Deserialize(const void* bytes, std::size_t size)
+{
+  std::span<const std::uint8_t> data(static_cast<const std::uint8_t*>(bytes), size);
+  ShaderReflection reflection;
+
+  std::uint32_t inputCount;
+  if (!Read(data, inputCount) || inputCount > data.size())
+    return false;
+
+  reflection.VertexInputs.resize(inputCount);
+  for (VertexInput& input : reflection.VertexInputs)
+  {
+    std::uint32_t type;
+    if (!Read(data, input.Name) || !Read(data, input.Location) || !Read(data, type) ||
+        !Read(data, input.Components) || !Read(data, input.Columns))
+      return false;
+
+    input.Type = static_cast<BaseType>(type);
+  }
+
+  if (!Read(data, reflection.UniformBuffers) || !Read(data, reflection.StorageBuffers) ||
+      !Read(data, reflection.SampledImages) || !Read(data, reflection.PushConstants))
+    return false;
+
+  for (std::size_t i = 0; i < 3; i++)
+  {
+    if (!Read(data, reflection.WorkgroupSize[i]) ||
+        !Read(data, reflection.WorkgroupSizeConstants[i]))
+      return false;
+  }
+
+  // Anything left over means the data wasn't written by this version
+  if (!data.empty())
+    return false;
+
+  *this = std::move(reflection);
+  return true;
+}
+
+} // namespace Vision
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Vision
+{
+
+// Everything the renderer needs to know about a shader's interface. It is extracted once, when the
+// shader is compiled (see ShaderReflector::Reflect), and stored next to the SPIRV in the cache and
+// in packs, so creating a pipeline never has to parse SPIRV again.
+struct ShaderReflection
+{
+  enum class BaseType : std::uint32_t
+  {
+    Float,
+    Int,
+    UInt,
+    Bool,
+    Other
+  };
+
+  struct VertexInput
+  {
+    std::string Name;
+    std::uint32_t Location;
+    BaseType Type;
+    std::uint32_t Components; // vec3 -> 3
+    std::uint32_t Columns;    // mat4 -> 4, otherwise 1
+  };
+
+  struct Resource
+  {
+    std::string Name;
+    std::uint32_t Binding;
+    std::uint32_t ArraySize = 1;
+    std::uint32_t Size = 0; // declared size in bytes of a block, zero for images
+  };
+
+  static constexpr std::uint32_t NoConstant = ~0u;
+
+  std::vector<VertexInput> VertexInputs; // sorted by location, vertex shaders only
+  std::vector<Resource> UniformBuffers;
+  std::vector<Resource> StorageBuffers;
+  std::vector<Resource> SampledImages;
+  std::vector<Resource> PushConstants; // the binding is meaningless here
+
+  // Compute only. A dimension declared with local_size_*_id lists the constant that overrides it.
+  std::uint32_t WorkgroupSize[3] = {1, 1, 1};
+  std::uint32_t WorkgroupSizeConstants[3] = {NoConstant, NoConstant, NoConstant};
+
+  std::vector<std::uint8_t> Serialize() const;
+  bool Deserialize(const void* data, std::size_t size);
+};
+
+} // namespace Vision
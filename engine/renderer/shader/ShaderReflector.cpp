@@ -1,11 +1,15 @@
 #include "ShaderReflector.h"
 
+#include <algorithm>
+
 namespace Vision
 {
 
-ShaderReflector::ShaderReflector(const ShaderSPIRV& shaderCode)
-  : reflector(shaderCode.SPIRV)
+ShaderReflector::ShaderReflector(const ShaderSPIRV& shaderCode,
+                                 const std::vector<SpecializationConstant>& constants)
+  : reflector(shaderCode.GetCode().data(), shaderCode.GetCode().size())
 {
+  ApplySpecializationConstants(reflector, constants);
   reflector.compile();
 }
 
@@ -13,7 +17,127 @@ glm::ivec3 ShaderReflector::GetThreadgroupSize() const
 {
   auto entries = reflector.get_entry_points_and_stages();
   auto workSize = reflector.get_entry_point(entries.front().name, entries.front().execution_model).workgroup_size;
-  return { workSize.x, workSize.y, workSize.z };
+  glm::ivec3 size = { workSize.x, workSize.y, workSize.z };
+
+  // Dimensions declared with local_size_*_id take the (possibly specialized) constant's value
+  spirv_cross::SpecializationConstant x, y, z;
+  reflector.get_work_group_size_specialization_constants(x, y, z);
+  if (x.id)
+    size.x = reflector.get_constant(x.id).scalar();
+  if (y.id)
+    size.y = reflector.get_constant(y.id).scalar();
+  if (z.id)
+    size.z = reflector.get_constant(z.id).scalar();
+
+  return size;
+}
+
+static ShaderReflection::BaseType BaseTypeFromSPIRType(spirv_cross::SPIRType::BaseType type)
+{
+  switch (type)
+  {
+    case spirv_cross::SPIRType::Float: return ShaderReflection::BaseType::Float;
+    case spirv_cross::SPIRType::Int: return ShaderReflection::BaseType::Int;
+    case spirv_cross::SPIRType::UInt: return ShaderReflection::BaseType::UInt;
+    case spirv_cross::SPIRType::Boolean: return ShaderReflection::BaseType::Bool;
+    default: return ShaderReflection::BaseType::Other;
+  }
+}
+
+ShaderReflection ShaderReflector::Reflect() const
+{
+  ShaderReflection reflection;
+  spirv_cross::ShaderResources res = reflector.get_shader_resources();
+  auto entries = reflector.get_entry_points_and_stages();
+
+  // Step 1) Vertex inputs, which are what a buffer layout has to match
+  if (entries.front().execution_model == spv::ExecutionModelVertex)
+  {
+    for (const spirv_cross::Resource& input : res.stage_inputs)
+    {
+      const spirv_cross::SPIRType& type = reflector.get_type(input.type_id);
+
+      ShaderReflection::VertexInput vertexInput;
+      vertexInput.Name = input.name;
+      vertexInput.Location = reflector.get_decoration(input.id, spv::DecorationLocation);
+      vertexInput.Type = BaseTypeFromSPIRType(type.basetype);
+      vertexInput.Components = type.vecsize;
+      vertexInput.Columns = type.columns;
+      reflection.VertexInputs.push_back(vertexInput);
+    }
+
+    std::sort(reflection.VertexInputs.begin(), reflection.VertexInputs.end(),
+              [](const auto& a, const auto& b) { return a.Location < b.Location; });
+  }
+
+  // Step 2) Buffers, which all record their declared size
+  auto reflectBlocks =
+      [this](const auto& resources, std::vector<ShaderReflection::Resource>& blocks)
+  {
+    for (const spirv_cross::Resource& resource : resources)
+    {
+      const spirv_cross::SPIRType& type = reflector.get_type(resource.base_type_id);
+
+      ShaderReflection::Resource block;
+      block.Name = resource.name;
+      block.Binding = reflector.get_decoration(resource.id, spv::DecorationBinding);
+      block.Size = static_cast<std::uint32_t>(reflector.get_declared_struct_size(type));
+      blocks.push_back(block);
+    }
+  };
+  reflectBlocks(res.uniform_buffers, reflection.UniformBuffers);
+  reflectBlocks(res.storage_buffers, reflection.StorageBuffers);
+  reflectBlocks(res.push_constant_buffers, reflection.PushConstants);
+
+  // Step 3) Sampled images
+  for (const SampledImage& image : GetSampledImages())
+  {
+    reflection.SampledImages.push_back({image.Name, static_cast<std::uint32_t>(image.Binding),
+                                        static_cast<std::uint32_t>(image.ArraySize), 0});
+  }
+
+  // Step 4) Workgroup size, remembering which dimensions can be specialized
+  if (entries.front().execution_model == spv::ExecutionModelGLCompute)
+  {
+    glm::ivec3 size = GetThreadgroupSize();
+    spirv_cross::SpecializationConstant constants[3];
+    reflector.get_work_group_size_specialization_constants(constants[0], constants[1],
+                                                           constants[2]);
+
+    for (int i = 0; i < 3; i++)
+    {
+      reflection.WorkgroupSize[i] = static_cast<std::uint32_t>(size[i]);
+      if (constants[i].id)
+        reflection.WorkgroupSizeConstants[i] = constants[i].constant_id;
+    }
+  }
+
+  return reflection;
+}
+
+std::shared_ptr<const ShaderReflection> ShaderReflector::GetReflection(const ShaderSPIRV& shader)
+{
+  if (shader.Reflection)
+    return shader.Reflection;
+
+  return std::make_shared<ShaderReflection>(ShaderReflector(shader).Reflect());
+}
+
+glm::ivec3 ShaderReflector::GetThreadgroupSize(const ShaderReflection& reflection,
+                                               const std::vector<SpecializationConstant>& constants)
+{
+  glm::ivec3 size;
+  for (int i = 0; i < 3; i++)
+  {
+    size[i] = static_cast<int>(reflection.WorkgroupSize[i]);
+    for (const SpecializationConstant& constant : constants)
+    {
+      if (constant.ID == reflection.WorkgroupSizeConstants[i])
+        size[i] = static_cast<int>(constant.Value);
+    }
+  }
+
+  return size;
 }
 
 std::vector<ShaderReflector::UniformBuffer> ShaderReflector::GetUniformBuffers() const
@@ -56,4 +180,21 @@ std::vector<ShaderReflector::SampledImage> ShaderReflector::GetSampledImages() c
   return std::move(images);
 }
 
+void ApplySpecializationConstants(spirv_cross::Compiler& compiler,
+                                  const std::vector<SpecializationConstant>& constants)
+{
+  if (constants.empty())
+    return;
+
+  for (const spirv_cross::SpecializationConstant& declared :
+       compiler.get_specialization_constants())
+  {
+    for (const SpecializationConstant& constant : constants)
+    {
+      if (constant.ID == declared.constant_id)
+        compiler.get_constant(declared.id).m.c[0].r[0].u32 = constant.Value;
+    }
+  }
+}
+
 }
\ No newline at end of file
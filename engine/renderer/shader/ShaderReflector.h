@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <spirv_reflect.hpp>
 #include <glm/glm.hpp>
 #include <vector>
@@ -17,7 +18,18 @@ namespace Vision
 class ShaderReflector
 {
 public:
-  ShaderReflector(const ShaderSPIRV& spirv);
+  ShaderReflector(const ShaderSPIRV& spirv,
+                  const std::vector<SpecializationConstant>& constants = {});
+
+  // Everything at once, this is what gets stored alongside the SPIRV.
+  ShaderReflection Reflect() const;
+
+  // Returns the shader's stored reflection, only parsing the SPIRV if it was built without one.
+  static std::shared_ptr<const ShaderReflection> GetReflection(const ShaderSPIRV& spirv);
+
+  // The workgroup size of a compute shader once the given constants are applied.
+  static glm::ivec3 GetThreadgroupSize(const ShaderReflection& reflection,
+                                       const std::vector<SpecializationConstant>& constants);
 
   glm::ivec3 GetThreadgroupSize() const;
 
@@ -40,4 +52,9 @@ private:
   spirv_cross::CompilerReflection reflector;
 };
 
+// Sets the values of a compiler's specialization constants before it emits code. Constants the
+// shader doesn't declare are ignored, since one list is shared by every stage of a pipeline.
+void ApplySpecializationConstants(spirv_cross::Compiler& compiler,
+                                  const std::vector<SpecializationConstant>& constants);
+
 }
\ No newline at end of file
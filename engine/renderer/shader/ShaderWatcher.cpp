@@ -0,0 +1,226 @@
+#include "ShaderWatcher.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+#include "core/Macros.h"
+
+#include "ShaderCache.h"
+#include "ShaderParser.h"
+
+#ifdef VISION_LINUX
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace Vision
+{
+
+ShaderWatcher::ShaderWatcher(const ShaderCompileOptions& options)
+    : compiler(options)
+{
+#ifdef VISION_LINUX
+  watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (watchFd < 0 || pipe(wakeFds) != 0)
+  {
+    std::cout << "Warning: shader hot reload unavailable" << std::endl;
+    if (watchFd >= 0)
+      close(watchFd);
+    watchFd = -1;
+    return;
+  }
+
+  thread = std::thread(&ShaderWatcher::WatchLoop, this);
+#endif
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+#ifdef VISION_LINUX
+  if (watchFd < 0)
+    return;
+
+  // Wake the thread out of poll, then clean up once it has left.
+  char wake = 0;
+  write(wakeFds[1], &wake, 1);
+  thread.join();
+
+  close(wakeFds[0]);
+  close(wakeFds[1]);
+  close(watchFd);
+#endif
+}
+
+void ShaderWatcher::Track(const std::string& filePath, const std::vector<ShaderSource>& sources,
+                          const std::vector<std::uint64_t>& sourceKeys,
+                          const std::vector<ShaderSPIRV>& compiled)
+{
+  if (watchFd < 0)
+    return;
+
+  std::error_code error;
+  std::filesystem::path path = std::filesystem::weakly_canonical(filePath, error);
+  if (error)
+    return;
+
+  std::vector<Section> sections;
+  for (std::size_t i = 0; i < sources.size(); i++)
+  {
+    // Sections that failed to compile will be picked up on the next edit anyway.
+    if (compiled[i].GetCode().empty())
+      continue;
+
+    sections.push_back({sources[i].Name, sources[i].Stage, sourceKeys[i], compiled[i].GetCodeHash()});
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  files[path.string()] = std::move(sections);
+  WatchDirectory(path.parent_path().string());
+  TrackDependencies(path.string(), sources);
+}
+
+void ShaderWatcher::WatchDirectory(const std::string& directory)
+{
+#ifdef VISION_LINUX
+  // Watching the same directory twice hands back the same descriptor.
+  int wd = inotify_add_watch(watchFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+  if (wd >= 0)
+    directories[wd] = directory;
+#endif
+}
+
+void ShaderWatcher::TrackDependencies(const std::string& filePath,
+                                      const std::vector<ShaderSource>& sources)
+{
+  for (const ShaderSource& source : sources)
+  {
+    for (const std::string& dependency : source.Dependencies)
+    {
+      std::vector<std::string>& users = dependents[dependency];
+      if (std::find(users.begin(), users.end(), filePath) != users.end())
+        continue;
+
+      users.push_back(filePath);
+      WatchDirectory(std::filesystem::path(dependency).parent_path().string());
+    }
+  }
+}
+
+std::vector<ShaderReload> ShaderWatcher::TakeReloads()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  reloadsAvailable.store(false, std::memory_order_relaxed);
+  return std::move(reloads);
+}
+
+void ShaderWatcher::WatchLoop()
+{
+#ifdef VISION_LINUX
+  alignas(inotify_event) char buffer[4096];
+  std::vector<std::string> changed;
+
+  while (true)
+  {
+    pollfd fds[2] = {{watchFd, POLLIN, 0}, {wakeFds[0], POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0)
+      continue;
+
+    if (fds[1].revents)
+      return;
+
+    // Editors save in bursts (write, rename, chmod...). Keep draining until things go quiet for a
+    // moment so a save only triggers one recompile.
+    changed.clear();
+    do
+    {
+      ssize_t length;
+      while ((length = read(watchFd, buffer, sizeof(buffer))) > 0)
+      {
+        for (char* ptr = buffer; ptr < buffer + length;)
+        {
+          const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+          ptr += sizeof(inotify_event) + event->len;
+          if (!event->len)
+            continue;
+
+          std::lock_guard<std::mutex> lock(mutex);
+          auto directory = directories.find(event->wd);
+          if (directory == directories.end())
+            continue;
+
+          std::string path = directory->second + "/" + event->name;
+          if (files.contains(path))
+            changed.push_back(path);
+
+          // A header may be shared by several files, each of which reloads on its own.
+          auto users = dependents.find(path);
+          if (users != dependents.end())
+            changed.insert(changed.end(), users->second.begin(), users->second.end());
+        }
+      }
+    } while (poll(fds, 1, 50) > 0);
+
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    for (const std::string& file : changed)
+      Reload(file);
+  }
+#endif
+}
+
+void ShaderWatcher::Reload(const std::string& filePath)
+{
+  ShaderParser parser;
+  std::vector<ShaderSource> sources = parser.ParseFile(filePath);
+
+  std::vector<Section> sections;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    sections = files[filePath];
+  }
+
+  // Only sections that already existed are reloaded, a new section has no pipelines to swap into.
+  std::vector<ShaderReload> compiled;
+  for (const ShaderSource& source : sources)
+  {
+    for (Section& section : sections)
+    {
+      if (section.Name != source.Name || section.Stage != source.Stage)
+        continue;
+
+      std::uint64_t key = ShaderCache::ComputeKey(source, compiler.GetOptions());
+      if (key == section.SourceKey)
+        break;
+
+      ShaderSPIRV shader = compiler.CompileSource(source);
+      if (shader.SPIRV.empty())
+      {
+        std::cout << "Keeping the previous version of " << source.Name << std::endl;
+        break;
+      }
+
+      std::uint64_t codeHash = shader.GetCodeHash();
+      if (codeHash != section.CodeHash)
+        compiled.push_back({section.CodeHash, codeHash, std::move(shader)});
+
+      section.SourceKey = key;
+      section.CodeHash = codeHash;
+      break;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  files[filePath] = std::move(sections);
+  TrackDependencies(filePath, sources); // the edit may have added includes
+  if (compiled.empty())
+    return;
+
+  std::cout << "Reloaded " << compiled.size() << " shader(s) from " << filePath << std::endl;
+  for (ShaderReload& reload : compiled)
+    reloads.push_back(std::move(reload));
+  reloadsAvailable.store(true, std::memory_order_relaxed);
+}
+
+} // namespace Vision
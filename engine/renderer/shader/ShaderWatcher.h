@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Shader.h"
+#include "ShaderCompiler.h"
+
+namespace Vision
+{
+
+// A section that was edited on disk and has already been recompiled. OldCodeHash identifies the
+// code it replaces and NewCodeHash the shader's, see RenderDevice::ReplaceShader.
+struct ShaderReload
+{
+  std::uint64_t OldCodeHash;
+  std::uint64_t NewCodeHash;
+  ShaderSPIRV Shader;
+};
+
+// Watches the files compiled by any ShaderCompiler it is attached to, and recompiles them when
+// they or any file they #include change. Only sections whose expanded text differs from the last
+// compile are rebuilt, so editing a shared header only touches the sections including it, and
+// all of it happens on the watcher's own thread. The render thread only has to check
+// HasReloads, which is a single atomic load.
+//
+// Watching is implemented with inotify, so on other platforms this never reports anything.
+class ShaderWatcher
+{
+public:
+  ShaderWatcher(const ShaderCompileOptions& options = {});
+  ~ShaderWatcher();
+
+  ShaderWatcher(const ShaderWatcher&) = delete;
+  ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+  bool IsSupported() const { return watchFd >= 0; }
+
+  // Called by ShaderCompiler after compiling a file, with one entry per section.
+  void Track(const std::string& filePath, const std::vector<ShaderSource>& sources,
+             const std::vector<std::uint64_t>& sourceKeys,
+             const std::vector<ShaderSPIRV>& compiled);
+
+  bool HasReloads() const { return reloadsAvailable.load(std::memory_order_relaxed); }
+  std::vector<ShaderReload> TakeReloads();
+
+private:
+  void WatchLoop();
+  void Reload(const std::string& filePath);
+
+  // Both expect the mutex to be held.
+  void WatchDirectory(const std::string& directory);
+  void TrackDependencies(const std::string& filePath, const std::vector<ShaderSource>& sources);
+
+private:
+  struct Section
+  {
+    std::string Name;
+    ShaderStage Stage;
+    std::uint64_t SourceKey;
+    std::uint64_t CodeHash;
+  };
+
+  ShaderCompiler compiler;
+
+  // Editors tend to save by replacing the file, so we watch directories rather than the files.
+  std::mutex mutex;
+  std::unordered_map<int, std::string> directories;
+  std::unordered_map<std::string, std::vector<Section>> files;
+  std::unordered_map<std::string, std::vector<std::string>> dependents; // include -> files
+
+  std::vector<ShaderReload> reloads;
+  std::atomic<bool> reloadsAvailable = false;
+
+  int watchFd = -1;
+  int wakeFds[2] = {-1, -1};
+  std::thread thread;
+};
+
+} // namespace Vision
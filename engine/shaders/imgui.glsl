@@ -0,0 +1,36 @@
+#section type(vertex) name(imguiVertex)
+#version 450 core
+
+layout (location = 0) in vec2 a_Position;
+layout (location = 1) in vec2 a_UV;
+layout (location = 2) in vec4 a_Color;
+
+layout (binding = 0) uniform matrices
+{
+  mat4 u_ViewProjection;
+};
+
+out vec4 v_FragColor;
+out vec2 v_FragUV;
+
+void main()
+{
+  v_FragColor = a_Color;
+  v_FragUV = a_UV;
+  gl_Position = u_ViewProjection * vec4(a_Position, 0.0, 1.0);
+}
+
+#section type(pixel) name(imguiPixel)
+#version 450 core
+
+in vec4 v_FragColor;
+in vec2 v_FragUV;
+
+layout (binding = 0) uniform sampler2D u_Texture;
+
+layout (location = 0) out vec4 f_FragColor;
+
+void main()
+{
+  f_FragColor = v_FragColor * texture(u_Texture, v_FragUV);
+}
@@ -0,0 +1,116 @@
+#section type(vertex) name(quadVertex)
+#version 450 core
+
+layout (location = 0) in vec2 a_Position;
+layout (location = 1) in vec4 a_Color;
+layout (location = 2) in vec2 a_UV;
+layout (location = 3) in int a_TextureID;
+layout (location = 4) in float a_TilingFactor;
+
+out vec2 v_UV;
+out vec4 v_Color;
+flat out int v_TextureID;
+
+layout (binding = 0) uniform matrices 
+{
+  mat4 mvp;
+};
+
+void main()
+{  
+  gl_Position = mvp * vec4(a_Position, 0.0, 1.0);
+  
+  v_UV = a_UV * a_TilingFactor;
+  v_Color = a_Color;
+  v_TextureID = a_TextureID;
+}
+
+#section type(pixel) name(quadPixel) variants(TEXTURED)
+#version 450 core
+
+in vec2 v_UV;
+in vec4 v_Color;
+flat in int v_TextureID;
+
+out vec4 FragColor;
+
+#ifdef TEXTURED
+layout (binding = 0) uniform sampler2D u_Textures[16];
+#endif
+
+void main()
+{
+  vec4 texColor = v_Color;
+
+#ifdef TEXTURED
+  switch(int(v_TextureID))
+	{
+		case  0: texColor *= texture(u_Textures[ 0], v_UV.st); break;
+		case  1: texColor *= texture(u_Textures[ 1], v_UV.st); break;
+		case  2: texColor *= texture(u_Textures[ 2], v_UV.st); break;
+		case  3: texColor *= texture(u_Textures[ 3], v_UV.st); break;
+		case  4: texColor *= texture(u_Textures[ 4], v_UV.st); break;
+		case  5: texColor *= texture(u_Textures[ 5], v_UV.st); break;
+		case  6: texColor *= texture(u_Textures[ 6], v_UV.st); break;
+		case  7: texColor *= texture(u_Textures[ 7], v_UV.st); break;
+		case  8: texColor *= texture(u_Textures[ 8], v_UV.st); break;
+		case  9: texColor *= texture(u_Textures[ 9], v_UV.st); break;
+		case 10: texColor *= texture(u_Textures[10], v_UV.st); break;
+		case 11: texColor *= texture(u_Textures[11], v_UV.st); break;
+		case 12: texColor *= texture(u_Textures[12], v_UV.st); break;
+		case 13: texColor *= texture(u_Textures[13], v_UV.st); break;
+		case 14: texColor *= texture(u_Textures[14], v_UV.st); break;
+		case 15: texColor *= texture(u_Textures[15], v_UV.st); break;
+	}
+#endif
+
+  FragColor = texColor;
+}
+
+#section type(vertex) name(pointVertex)
+#version 450 core
+
+layout (location = 0) in vec2 a_Position;
+layout (location = 1) in vec4 a_Color;
+layout (location = 2) in vec2 a_UV;
+layout (location = 3) in float a_Border;
+
+out vec2 v_UVNorm;
+out vec4 v_Color;
+out float v_Border;
+
+layout (binding = 0) uniform matrices 
+{
+  mat4 mvp;
+};
+
+void main()
+{  
+  gl_Position = mvp * vec4(a_Position, 0.0, 1.0);
+
+  v_Color = a_Color;
+  v_UVNorm = a_UV * 2.0 - 1.0; // normalize from -1 to 1
+  v_Border = a_Border;
+}
+
+#section type(pixel) name(pointPixel)
+#version 450 core
+
+in vec2 v_UVNorm;
+in vec4 v_Color;
+in float v_Border;
+
+out vec4 FragColor;
+
+void main()
+{
+  float dist = length(v_UVNorm);
+  float radius = 1.0;
+
+	float delta = fwidth(dist);
+	float outerFade = smoothstep(radius + delta, radius - delta, dist);
+  float innerFade = 1.0 - float(v_Border > 0) * smoothstep(radius - v_Border + delta, radius - v_Border - delta, dist);
+  float alpha = min(outerFade, innerFade);
+
+	FragColor = vec4(v_Color.xyz, v_Color.w * alpha);
+}
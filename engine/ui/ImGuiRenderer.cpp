@@ -7,7 +7,7 @@
 
 #include "core/App.h"
 
-#include "renderer/shader/ShaderCompiler.h"
+#include "renderer/shader/BuiltinShaders.h"
 
 namespace Vision
 {
@@ -209,43 +209,6 @@ void ImGuiRenderer::GenerateBuffers()
   ubo = device->CreateBuffer(uboDesc);
 }
 
-static const char* vertexShader = R"(
-#version 450 core
-
-layout (location = 0) in vec2 a_Position;
-layout (location = 1) in vec2 a_UV;
-layout (location = 2) in vec4 a_Color;
-
-layout (binding = 0) uniform matrices
-{
-  mat4 u_ViewProjection;
-};
-
-out vec4 v_FragColor;
-out vec2 v_FragUV;
-
-void main()
-{
-  v_FragColor = a_Color;
-  v_FragUV = a_UV;
-  gl_Position = u_ViewProjection * vec4(a_Position, 0.0, 1.0);
-})";
-
-static const char* pixelShader = R"(
-#version 450 core
-
-in vec4 v_FragColor;
-in vec2 v_FragUV;
-
-layout (binding = 0) uniform sampler2D u_Texture;
-
-layout (location = 0) out vec4 f_FragColor;
-
-void main()
-{
-  f_FragColor = v_FragColor * texture(u_Texture, v_FragUV);
-})";
-
 void ImGuiRenderer::GeneratePipeline()
 {
   RenderPipelineDesc pipelineDesc;
@@ -260,11 +223,8 @@ void ImGuiRenderer::GeneratePipeline()
   pipelineDesc.Layouts = {imVertLayout};
 
   // create and set the shader
-  ShaderCompiler compiler;
-  ShaderSource vertexSource = {ShaderStage::Vertex, "imguiVertex", vertexShader};
-  ShaderSource pixelSource = {ShaderStage::Pixel, "imguiPixel", pixelShader};
-  pipelineDesc.VertexShader = compiler.CompileSource(vertexSource);
-  pipelineDesc.PixelShader = compiler.CompileSource(pixelSource);
+  pipelineDesc.VertexShader = GetBuiltinShader("imguiVertex", ShaderStage::Vertex);
+  pipelineDesc.PixelShader = GetBuiltinShader("imguiPixel", ShaderStage::Pixel);
 
   // set the imgui rendering state info
   pipelineDesc.Blending = true;
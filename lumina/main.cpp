@@ -4,7 +4,7 @@
 #include <iostream>
 
 #include "renderer/shader/Shader.h"
-#include "renderer/shader/ShaderCompiler.h"
+#include "renderer/shader/ShaderPack.h"
 
 namespace Lumina
 {
@@ -13,9 +13,8 @@ class Lumina : public Vision::App
 public:
   Lumina() : Vision::App("Lumina")
   {
-    Vision::ShaderCompiler compiler;
-    std::vector<Vision::ShaderSPIRV> shaderSPIRV =
-        compiler.CompileFile("resrouces/distShader.glsl");
+    // Resource shaders are compiled at build time by visionc (see the ShaderPack target)
+    shaderPack = Vision::ShaderPack::Open("shaders.pack");
 
     // Prepare the renderer data
     Vision::RenderPassDesc rpDesc;
@@ -60,6 +59,7 @@ private:
   Vision::ID renderPass;
   Vision::PerspectiveCamera camera;
 
+  std::shared_ptr<Vision::ShaderPack> shaderPack;
   Vision::ID distShader;
   Vision::Mesh* planeMesh;
 };
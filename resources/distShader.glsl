@@ -1,4 +1,4 @@
-#type vertex
+#section type(vertex) name(distVertex)
 #version 450 core
 
 layout(location = 0) in vec3 a_Position;
@@ -14,7 +14,7 @@ void main()
   v_UV = a_UV;
 }
 
-#type hull
+#section type(hull) name(distHull)
 #version 450 core
 
 in vec2 v_UV[];
@@ -25,15 +25,7 @@ out vec2 UV[];
 
 layout(binding = 0) uniform sampler2D heightMap;
 
-layout(push_constant) uniform pushConstants
-{
-  mat4 u_View;
-  mat4 u_Projection;
-  mat4 u_ViewProjection;
-  mat4 u_ViewInverse;
-  vec2 u_ViewportSize;
-  float u_Time;
-};
+#include "include/pushConstants.glsl"
 
 float distanceTess(vec4 p0, vec4 p1, vec2 t0, vec2 t1)
 {
@@ -96,22 +88,14 @@ void main()
   }
 }
 
-#type domain
+#section type(domain) name(distDomain)
 #version 450 core
 
 layout(quads, fractional_odd_spacing, ccw) in;
 
 in vec2 UV[];
 
-layout(push_constant) uniform pushConstants
-{
-  mat4 u_View;
-  mat4 u_Projection;
-  mat4 u_ViewProjection;
-  mat4 u_ViewInverse;
-  vec2 u_ViewportSize;
-  float u_Time;
-};
+#include "include/pushConstants.glsl"
 
 layout(binding = 0) uniform sampler2D heightMap;
 
@@ -155,7 +139,7 @@ void main()
   gl_Position = u_ViewProjection * pos;
 }
 
-#type fragment
+#section type(fragment) name(distPixel)
 #version 450 core
 
 in float height;
@@ -0,0 +1,12 @@
+// Engine data pushed by the Renderer before every draw. Mirrors PushConstant in Renderer.cpp.
+// Binding 15 is PushConstantBinding, which RenderDevice::PushConstants fills.
+layout(binding = 15) uniform pushConstants
+{
+  mat4 u_View;
+  mat4 u_Projection;
+  mat4 u_ViewProjection;
+  mat4 u_ViewInverse;
+  vec2 u_ViewportSize;
+  float u_Time;
+  float dummy; // 16 byte alignment
+};
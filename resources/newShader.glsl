@@ -6,7 +6,7 @@ int method()
     return 2;
 }
 
-#section type(computfe) name(horizontalFFT)    
+#section type(compute) name(horizontalFFT)    
 
 layout (local_size_x = 50) in;
 void main()
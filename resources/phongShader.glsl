@@ -1,20 +1,12 @@
-#type vertex
-#version 410 core
+#section type(vertex) name(phongVertex)
+#version 450 core
 
 layout(location = 0) in vec3 a_Position;
 layout(location = 1) in vec3 a_Normal;
 layout(location = 2) in vec4 a_Color;
 layout(location = 3) in vec2 a_UV;
 
-layout(push_constant) uniform pushConstants
-{
-  mat4 u_View;
-  mat4 u_Projection;
-  mat4 u_ViewProjection;
-  mat4 u_ViewInverse;
-  vec2 u_ViewportSize;
-  float u_Time;
-};
+#include "include/pushConstants.glsl"
 
 out vec3 v_WorldPos;
 out vec2 v_UV;
@@ -32,8 +24,8 @@ void main()
   v_WorldPos = a_Position.xyz;
 }
 
-#type fragment
-#version 410 core
+#section type(fragment) name(phongPixel)
+#version 450 core
 
 in vec3 v_WorldPos;
 in vec2 v_UV;
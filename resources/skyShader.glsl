@@ -1,19 +1,9 @@
-#type vertex
+#section type(vertex) name(skyVertex)
 #version 450 core
 
 layout(location = 0) in vec3 a_Pos;
 
-// We use uniform binding zero for engine resources.
-layout(binding = 0) uniform pushConstants
-{
-  mat4 u_View;
-  mat4 u_Projection;
-  mat4 u_ViewProjection;
-  mat4 u_ViewInverse;
-  vec2 u_ViewportSize;
-  float u_Time;
-  float dummy; // 16 byte alignment
-};
+#include "include/pushConstants.glsl"
 
 out vec3 texCoord;
 
@@ -25,7 +15,7 @@ void main()
   gl_Position = pos.xyww;
 }
 
-#type fragment
+#section type(fragment) name(skyPixel)
 #version 450 core
 
 in vec3 texCoord;
@@ -0,0 +1,384 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "renderer/shader/ShaderAnalyzer.h"
+#include "renderer/shader/ShaderCompiler.h"
+#include "renderer/shader/ShaderPack.h"
+#include "renderer/shader/ShaderReflector.h"
+
+// visionc is the offline shader compiler. It compiles any number of shader files into a single
+// shader pack, optionally emitting it as a C++ header so it can be embedded in a binary.
+//
+//   visionc -o shaders.pack resources/phongShader.glsl resources/skyShader.glsl ...
+//   visionc -o BuiltinShaderPack.h --embed BuiltinShaderPack engine/shaders/*.glsl
+//   visionc --profile-report resources/*.glsl
+//   visionc --analyze --budgets engine/shaders/budgets.txt engine/shaders/*.glsl
+
+static void PrintUsage()
+{
+  std::cout << "usage: visionc -o <output> [options] <shader files...>" << std::endl;
+  std::cout << "       visionc --analyze [options] <shader files...>" << std::endl;
+  std::cout << "  --embed <symbol>   write the pack as a C++ header defining <symbol>" << std::endl;
+  std::cout << "  --reflect <file>   write the reflection data of every shader as JSON" << std::endl;
+  std::cout << "  --no-cache         ignore and don't update the SPIRV cache" << std::endl;
+  std::cout << "  --profile <name>   debug or release (default)" << std::endl;
+  std::cout << "  --profile-report   compare every profile's output size and compile time"
+            << std::endl;
+  std::cout << "  --analyze          print the static cost of every shader" << std::endl;
+  std::cout << "  --budgets <file>   warn about shaders whose cost exceeds a budget" << std::endl;
+  std::cout << "  --fail-over-budget treat exceeded budgets as errors" << std::endl;
+}
+
+static bool ParseProfile(const char* name, Vision::ShaderProfile& profile)
+{
+  if (std::strcmp(name, "debug") == 0)
+    profile = Vision::ShaderProfile::Debug;
+  else if (std::strcmp(name, "release") == 0)
+    profile = Vision::ShaderProfile::Release;
+  else
+    return false;
+
+  return true;
+}
+
+// Compiles everything once per profile, bypassing the cache so the timings are real.
+static void PrintProfileReport(const std::vector<std::string>& inputs)
+{
+  constexpr Vision::ShaderProfile profiles[] = {Vision::ShaderProfile::Debug,
+                                                Vision::ShaderProfile::Release};
+  constexpr std::size_t numProfiles = std::size(profiles);
+  std::vector<Vision::ShaderCompileReport> reports[numProfiles];
+  for (std::size_t i = 0; i < numProfiles; i++)
+  {
+    Vision::ShaderCompiler compiler(profiles[i]);
+    std::vector<Vision::ShaderSPIRV> shaders;
+    compiler.CompileFiles(inputs, shaders, false, &reports[i]);
+  }
+
+  std::printf("%-32s %18s %18s\n", "shader", "debug", "release");
+  std::size_t totalBytes[numProfiles] = {};
+  float totalMilliseconds[numProfiles] = {};
+  for (std::size_t shader = 0; shader < reports[0].size(); shader++)
+  {
+    std::printf("%-32s", reports[0][shader].Name.c_str());
+    for (std::size_t i = 0; i < numProfiles; i++)
+    {
+      const Vision::ShaderCompileReport& report = reports[i][shader];
+      std::printf(" %8zuB %7.2fms", report.Bytes, report.Milliseconds);
+      totalBytes[i] += report.Bytes;
+      totalMilliseconds[i] += report.Milliseconds;
+    }
+    std::printf("\n");
+  }
+
+  std::printf("%-32s", "total");
+  for (std::size_t i = 0; i < numProfiles; i++)
+    std::printf(" %8zuB %7.2fms", totalBytes[i], totalMilliseconds[i]);
+  std::printf("\n");
+}
+
+static const char* StageToString(Vision::ShaderStage stage)
+{
+  switch (stage)
+  {
+    case Vision::ShaderStage::Vertex: return "vertex";
+    case Vision::ShaderStage::Pixel: return "pixel";
+    case Vision::ShaderStage::Compute: return "compute";
+    case Vision::ShaderStage::Domain: return "domain";
+    case Vision::ShaderStage::Hull: return "hull";
+    case Vision::ShaderStage::Geometry: return "geometry";
+    default: return "invalid";
+  }
+}
+
+// A budget caps one metric of every shader it applies to. The scope is a shader name, a stage or *.
+struct Budget
+{
+  std::string Scope;
+  std::string Metric;
+  std::size_t Limit;
+};
+
+// One budget per line as "<scope> <metric> <limit>". Anything after a # is a comment.
+static bool LoadBudgets(const std::string& filePath, std::vector<Budget>& budgets)
+{
+  std::ifstream stream(filePath);
+  if (!stream.is_open())
+  {
+    std::cout << "visionc: unable to read " << filePath << std::endl;
+    return false;
+  }
+
+  std::vector<std::pair<std::string, std::size_t>> metrics = Vision::ShaderCost().GetMetrics();
+  std::string line;
+  for (std::size_t lineNumber = 1; std::getline(stream, line); lineNumber++)
+  {
+    std::istringstream words(line.substr(0, line.find('#')));
+    Budget budget;
+    if (!(words >> budget.Scope))
+      continue;
+
+    bool known = false;
+    if (words >> budget.Metric >> budget.Limit)
+      for (const auto& [name, value] : metrics)
+        known |= (name == budget.Metric);
+
+    if (!known)
+    {
+      std::cout << "visionc: " << filePath << ":" << lineNumber << ": expected <shader|stage|*> "
+                << "<metric> <limit>" << std::endl;
+      return false;
+    }
+
+    budgets.push_back(budget);
+  }
+
+  return true;
+}
+
+// Prints a table of every shader's cost if asked to, and warns about every budget it exceeds.
+// Returns false if any budget was exceeded.
+static bool AnalyzeShaders(const std::vector<Vision::ShaderSPIRV>& shaders,
+                           const std::vector<Budget>& budgets, bool printTable)
+{
+  std::vector<std::pair<std::string, std::size_t>> names = Vision::ShaderCost().GetMetrics();
+  if (printTable)
+  {
+    std::printf("%-32s %-8s", "shader", "stage");
+    for (const auto& [name, value] : names)
+      std::printf(" %s", name.c_str());
+    std::printf("\n");
+  }
+
+  bool withinBudget = true;
+  for (const Vision::ShaderSPIRV& shader : shaders)
+  {
+    std::vector<std::pair<std::string, std::size_t>> metrics =
+        Vision::AnalyzeShader(shader).GetMetrics();
+
+    if (printTable)
+    {
+      std::printf("%-32s %-8s", shader.Name.c_str(), StageToString(shader.Stage));
+      for (const auto& [name, value] : metrics)
+        std::printf(" %*zu", static_cast<int>(name.size()), value);
+      std::printf("\n");
+    }
+
+    for (const Budget& budget : budgets)
+    {
+      if (budget.Scope != "*" && budget.Scope != shader.Name &&
+          budget.Scope != StageToString(shader.Stage))
+        continue;
+
+      for (const auto& [name, value] : metrics)
+      {
+        if (name != budget.Metric || value <= budget.Limit)
+          continue;
+
+        std::cout << "visionc: warning: " << shader.Name << " " << name << " " << value
+                  << " exceeds budget " << budget.Limit << std::endl;
+        withinBudget = false;
+      }
+    }
+  }
+
+  return withinBudget;
+}
+
+static bool WriteEmbeddedHeader(const std::string& filePath, const std::string& symbol,
+                                const std::vector<uint8_t>& data)
+{
+  std::ofstream stream(filePath, std::ios::out | std::ios::trunc);
+  if (!stream.is_open())
+  {
+    std::cout << "visionc: unable to write " << filePath << std::endl;
+    return false;
+  }
+
+  // Aligned so that ShaderPack::FromMemory can reference the payloads in place.
+  stream << "// Generated by visionc, do not edit.\n#pragma once\n\n";
+  stream << "alignas(16) static const unsigned char " << symbol << "[] = {";
+  for (std::size_t i = 0; i < data.size(); i++)
+  {
+    char byte[8];
+    std::snprintf(byte, sizeof(byte), "0x%02x,", data[i]);
+    stream << ((i % 16 == 0) ? "\n  " : "") << byte;
+  }
+  stream << "\n};\n";
+
+  return stream.good();
+}
+
+static void WriteResources(std::ofstream& stream, const char* name,
+                           const std::vector<Vision::ShaderReflection::Resource>& resources,
+                           bool last = false)
+{
+  stream << "    \"" << name << "\": [";
+  for (std::size_t j = 0; j < resources.size(); j++)
+    stream << (j ? ", " : "") << "{\"name\": \"" << resources[j].Name
+           << "\", \"binding\": " << resources[j].Binding
+           << ", \"arraySize\": " << resources[j].ArraySize << ", \"size\": " << resources[j].Size
+           << "}";
+  stream << "]" << (last ? "" : ",") << "\n";
+}
+
+static bool WriteReflection(const std::string& filePath,
+                            const std::vector<Vision::ShaderSPIRV>& shaders)
+{
+  std::ofstream stream(filePath, std::ios::out | std::ios::trunc);
+  if (!stream.is_open())
+  {
+    std::cout << "visionc: unable to write " << filePath << std::endl;
+    return false;
+  }
+
+  stream << "[\n";
+  for (std::size_t i = 0; i < shaders.size(); i++)
+  {
+    const Vision::ShaderSPIRV& shader = shaders[i];
+    std::shared_ptr<const Vision::ShaderReflection> reflection =
+        Vision::ShaderReflector::GetReflection(shader);
+
+    stream << "  {\n";
+    stream << "    \"name\": \"" << shader.Name << "\",\n";
+    stream << "    \"stage\": \"" << StageToString(shader.Stage) << "\",\n";
+
+    if (shader.Stage == Vision::ShaderStage::Compute)
+    {
+      const std::uint32_t* size = reflection->WorkgroupSize;
+      stream << "    \"threadgroupSize\": [" << size[0] << ", " << size[1] << ", " << size[2]
+             << "],\n";
+    }
+
+    if (shader.Stage == Vision::ShaderStage::Vertex)
+    {
+      stream << "    \"vertexInputs\": [";
+      const auto& inputs = reflection->VertexInputs;
+      for (std::size_t j = 0; j < inputs.size(); j++)
+        stream << (j ? ", " : "") << "{\"name\": \"" << inputs[j].Name
+               << "\", \"location\": " << inputs[j].Location
+               << ", \"components\": " << inputs[j].Components
+               << ", \"columns\": " << inputs[j].Columns << "}";
+      stream << "],\n";
+    }
+
+    WriteResources(stream, "uniformBuffers", reflection->UniformBuffers);
+    WriteResources(stream, "storageBuffers", reflection->StorageBuffers);
+    WriteResources(stream, "pushConstants", reflection->PushConstants);
+    WriteResources(stream, "sampledImages", reflection->SampledImages, true);
+
+    stream << "  }" << (i + 1 < shaders.size() ? "," : "") << "\n";
+  }
+  stream << "]\n";
+
+  return stream.good();
+}
+
+int main(int argc, char** argv)
+{
+  std::string outputPath, embedSymbol, reflectPath, budgetsPath;
+  std::vector<std::string> inputs;
+  bool canCache = true, profileReport = false, analyze = false, failOverBudget = false;
+  Vision::ShaderProfile profile = Vision::ShaderProfile::Release;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+      outputPath = argv[++i];
+    else if (std::strcmp(argv[i], "--embed") == 0 && i + 1 < argc)
+      embedSymbol = argv[++i];
+    else if (std::strcmp(argv[i], "--reflect") == 0 && i + 1 < argc)
+      reflectPath = argv[++i];
+    else if (std::strcmp(argv[i], "--no-cache") == 0)
+      canCache = false;
+    else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc &&
+             ParseProfile(argv[i + 1], profile))
+      i++;
+    else if (std::strcmp(argv[i], "--profile-report") == 0)
+      profileReport = true;
+    else if (std::strcmp(argv[i], "--analyze") == 0)
+      analyze = true;
+    else if (std::strcmp(argv[i], "--budgets") == 0 && i + 1 < argc)
+      budgetsPath = argv[++i];
+    else if (std::strcmp(argv[i], "--fail-over-budget") == 0)
+      failOverBudget = true;
+    else if (argv[i][0] == '-')
+    {
+      PrintUsage();
+      return 1;
+    }
+    else
+      inputs.push_back(argv[i]);
+  }
+
+  if (profileReport && !inputs.empty())
+  {
+    PrintProfileReport(inputs);
+    if (outputPath.empty())
+      return 0;
+  }
+
+  if ((outputPath.empty() && !analyze) || inputs.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  std::vector<Budget> budgets;
+  if (!budgetsPath.empty() && !LoadBudgets(budgetsPath, budgets))
+    return 1;
+
+  Vision::ShaderCompiler compiler(profile);
+  std::vector<Vision::ShaderSPIRV> shaders;
+  std::vector<Vision::ShaderCompileReport> reports;
+  compiler.CompileFiles(inputs, shaders, canCache, &reports);
+
+  // A broken shader fails the build rather than producing a pack with a hole in it.
+  bool failed = false;
+  Vision::ShaderPackWriter writer;
+  for (std::size_t i = 0; i < shaders.size(); i++)
+  {
+    if (shaders[i].SPIRV.empty())
+    {
+      std::cout << "visionc: failed to compile " << reports[i].Name << " in " << reports[i].File
+                << std::endl;
+      failed = true;
+      continue;
+    }
+
+    writer.Add(shaders[i], reports[i].SourceKey);
+  }
+
+  if (failed)
+    return 1;
+
+  // Analysis only reads the SPIRV, so it runs on machines without a GPU like the rest of visionc.
+  if ((analyze || !budgets.empty()) && !AnalyzeShaders(shaders, budgets, analyze) &&
+      failOverBudget)
+    return 1;
+
+  if (outputPath.empty())
+    return 0;
+
+  bool written = embedSymbol.empty()
+                     ? writer.Write(outputPath)
+                     : WriteEmbeddedHeader(outputPath, embedSymbol, writer.Serialize());
+  if (!written)
+    return 1;
+
+  if (!reflectPath.empty() && !WriteReflection(reflectPath, shaders))
+    return 1;
+
+  std::size_t deduplicated = 0;
+  for (const Vision::ShaderCompileReport& report : reports)
+    deduplicated += report.Deduplicated;
+
+  std::cout << "visionc: packed " << shaders.size() << " shaders into " << outputPath << " ("
+            << deduplicated << " deduplicated)" << std::endl;
+  return 0;
+}